@@ -0,0 +1,221 @@
+#include "cache.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Throughput benchmark of the simulator, self-contained: the accesses are generated in memory.       */
+/* Phases: trace parsing (text, binary, pipelined), read/write lookups (hits and misses), allocate,    */
+/* evict, the whole run() loop and access_batch, from direct-mapped to 32-way and for both write-policy */
+/* pairs. "bench [-n accesses] [-r repeats] [-l label] [-o results.csv]": best of "repeats" timings,    */
+/* printed as accesses/second and ns/access and appended to the CSV file when given.                  */
+
+typedef struct{
+    string phase;
+    unsigned associativity;
+    const char *policy;
+    unsigned long long accesses;
+    double seconds;
+} result_t;
+
+static unsigned long long sink; //keeps the measured results alive
+
+static unsigned long long next_random(unsigned long long &seed){
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+/* accesses spread over "footprint" bytes, 30% writes */
+static vector<trace_entry_t> generate(size_t count, unsigned long long footprint, unsigned long long seed){
+    vector<trace_entry_t> entries(count);
+    for (size_t i = 0; i < count; i++) {
+        unsigned long long r = next_random(seed);
+        entries[i].address = (address_t)(0x7f0000000000ULL + (r >> 8) % footprint);
+        entries[i].op = ((r & 0xFF) < 77) ? TRACE_WRITE : TRACE_READ;
+    }
+    return entries;
+}
+
+/* best wall-clock time of "repeats" runs of "body" */
+template <typename BODY>
+static double best_of(unsigned repeats, BODY body){
+    double best = 0;
+    for (unsigned r = 0; r < repeats; r++) {
+        auto start = chrono::steady_clock::now();
+        body();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+static bool write_text(const char *filename, const vector<trace_entry_t> &entries){
+    FILE *out = fopen(filename, "w");
+    if (out == NULL) return false;
+    for (size_t i = 0; i < entries.size(); i++) {
+        fprintf(out, "%c 0x%llx\n", entries[i].op == TRACE_WRITE ? 'w' : 'r', (unsigned long long)entries[i].address);
+    }
+    return fclose(out) == 0;
+}
+
+static bool write_binary(const char *filename, const vector<trace_entry_t> &entries){
+    trace_writer writer;
+    if (!writer.open(filename)) return false;
+    for (size_t i = 0; i < entries.size(); i++) {
+        writer.write(entries[i]);
+    }
+    return writer.close();
+}
+
+static double parse(const char *filename, trace_mode_t mode, unsigned repeats){
+    return best_of(repeats, [&](){
+        trace_reader reader;
+        trace_entry_t entry;
+        reader.open(filename, mode);
+        while (reader.next(entry)) {
+            sink += entry.address;
+        }
+    });
+}
+
+int main(int argc, char **argv){
+
+    size_t count = 4 << 20;
+    unsigned repeats = 3;
+    const char *label = "default";
+    const char *csv = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:r:l:o:")) != -1) {
+        switch (option) {
+            case 'n': count = strtoull(optarg, NULL, 10); break;
+            case 'r': repeats = strtoul(optarg, NULL, 10); break;
+            case 'l': label = optarg; break;
+            case 'o': csv = optarg; break;
+            default:
+                cerr << "usage: " << argv[0] << " [-n accesses] [-r repeats] [-l label] [-o results.csv]" << endl;
+                return 1;
+        }
+    }
+    if (count == 0 || repeats == 0) return 1;
+
+    const unsigned size = 32 * KB;
+    const unsigned line = 64;
+    const unsigned associativities[] = {1, 2, 4, 8, 16, 32};
+    vector<result_t> results;
+
+    // trace parsing
+    vector<trace_entry_t> trace = generate(count, 64ULL * size, 1);
+    char text[] = "/tmp/bench_text_XXXXXX";
+    char binary[] = "/tmp/bench_binary_XXXXXX";
+    close(mkstemp(text));
+    close(mkstemp(binary));
+    if (!write_text(text, trace) || !write_binary(binary, trace)) {
+        cerr << "cannot write the benchmark traces" << endl;
+        return 1;
+    }
+    results.push_back({"parse-text", 0, "-", count, parse(text, TRACE_MMAP, repeats)});
+    results.push_back({"parse-binary", 0, "-", count, parse(binary, TRACE_MMAP, repeats)});
+    results.push_back({"parse-pipeline", 0, "-", count, parse(text, TRACE_PIPELINE, repeats)});
+    unlink(text);
+    unlink(binary);
+
+    // resident lines (one cache worth) and absent ones, visited in random order
+    vector<trace_entry_t> resident = generate(count, size, 2);
+    vector<trace_entry_t> absent = generate(count, 64ULL * size, 3);
+    for (size_t i = 0; i < count; i++) {
+        absent[i].address += 0x10000000000LL;
+    }
+
+    for (unsigned a = 0; a < sizeof(associativities) / sizeof(associativities[0]); a++) {
+        for (unsigned p = 0; p < 2; p++) {
+            unsigned assoc = associativities[a];
+            write_policy_t hit_policy = p ? WRITE_THROUGH : WRITE_BACK;
+            write_policy_t miss_policy = p ? NO_WRITE_ALLOCATE : WRITE_ALLOCATE;
+            const char *policy = p ? "WT/NWA" : "WB/WA";
+            cache *mycache = new cache(size, assoc, line, hit_policy, miss_policy, 5, 100, 48);
+
+            // every resident line allocated once (they fit exactly)
+            for (address_t block = 0; block < (address_t)size; block += line) {
+                mycache->allocate(0x7f0000000000LL + block);
+            }
+
+            double seconds = best_of(repeats, [&](){
+                for (size_t i = 0; i < count; i++) sink += mycache->read(resident[i].address);
+            });
+            results.push_back({"read-hit", assoc, policy, count, seconds});
+
+            seconds = best_of(repeats, [&](){
+                for (size_t i = 0; i < count; i++) sink += mycache->read(absent[i].address);
+            });
+            results.push_back({"read-miss", assoc, policy, count, seconds});
+
+            seconds = best_of(repeats, [&](){
+                for (size_t i = 0; i < count; i++) sink += mycache->write(resident[i].address);
+            });
+            results.push_back({"write-hit", assoc, policy, count, seconds});
+
+            seconds = best_of(repeats, [&](){
+                for (size_t i = 0; i < count; i++) sink += mycache->evict(i & (size / line / assoc - 1));
+            });
+            results.push_back({"evict", assoc, policy, count, seconds});
+
+            seconds = best_of(repeats, [&](){
+                for (size_t i = 0; i < count; i++) sink += mycache->allocate(absent[i].address);
+            });
+            results.push_back({"allocate", assoc, policy, count, seconds});
+            delete mycache;
+
+            // whole loop over the in-memory trace, on a fresh cache each time
+            seconds = best_of(repeats, [&](){
+                cache simulator(size, assoc, line, hit_policy, miss_policy, 5, 100, 48);
+                simulator.load_trace(trace.data(), trace.size());
+                simulator.run();
+                sink += simulator.get_statistics().eviction;
+            });
+            results.push_back({"run", assoc, policy, count, seconds});
+
+            // same accesses through the batch entry point
+            seconds = best_of(repeats, [&](){
+                cache simulator(size, assoc, line, hit_policy, miss_policy, 5, 100, 48);
+                simulator.access_batch(trace.data(), trace.size());
+                sink += simulator.get_statistics().eviction;
+            });
+            results.push_back({"access-batch", assoc, policy, count, seconds});
+        }
+    }
+
+    cout << setw(14) << left << "phase" << right << setw(7) << "assoc" << setw(8) << "policy"
+         << setw(14) << "accesses/s" << setw(12) << "ns/access" << endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const result_t &r = results[i];
+        cout << setw(14) << left << r.phase << right << setw(7) << r.associativity << setw(8) << r.policy
+             << setw(14) << fixed << setprecision(0) << r.accesses / r.seconds
+             << setw(12) << setprecision(2) << r.seconds * 1e9 / r.accesses << endl;
+    }
+
+    if (csv != NULL) {
+        ofstream out(csv, ios::app);
+        if (out.tellp() == 0) {
+            out << "label,phase,associativity,policy,accesses,seconds,accesses_per_second,ns_per_access" << endl;
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            const result_t &r = results[i];
+            out << label << ',' << r.phase << ',' << r.associativity << ',' << r.policy << ',' << r.accesses << ','
+                << setprecision(6) << r.seconds << ',' << setprecision(0) << fixed << r.accesses / r.seconds << ','
+                << setprecision(3) << r.seconds * 1e9 / r.accesses << endl;
+            out.unsetf(ios::fixed);
+        }
+    }
+    return (sink == 0xDEADBEEF) ? 2 : 0;
+}
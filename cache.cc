@@ -1,17 +1,17 @@
 #include "cache.h"
+#include "engine.h"
 #include <stdlib.h>
 #include <iostream>
 #include <iomanip>
 #include <math.h>
 #include <string.h>
+#include <sys/mman.h>
 
 using namespace std;
 
 #define UNDEFINED 0xFFFFFFFFFFFFFFFF
 #define START 0x0
 
-vector <vector <cachee_t>> table;
-
 cache::cache(unsigned size,
              unsigned associativity,
              unsigned line_size,
@@ -19,9 +19,15 @@ cache::cache(unsigned size,
              write_policy_t wr_miss_policy,
              unsigned hit_time,
              unsigned miss_penalty,
-             unsigned address_width
+             unsigned address_width,
+             replacement_policy_t replacement_policy,
+             index_function_t index_function
 ){
 
+    if (associativity == 0) {
+        associativity = size / line_size;
+    }
+
     cache_size = size;
     coeval = associativity;
     lsize = line_size;
@@ -30,45 +36,110 @@ cache::cache(unsigned size,
     hitT = hit_time;
     penalty = miss_penalty;
     width = address_width;
+    replacement = replacement_policy;
+
+    if (line_size == 0 || (line_size & (line_size - 1)) != 0) {
+        cerr << "the cache line size must be a power of two" << endl;
+        exit(EXIT_FAILURE);
+    }
 
     sized = (size/line_size)/associativity;
-    offset = log2(line_size);
-    indexes = log2(sized);
+    if (sized == 0) {
+        cerr << "the cache must hold at least one set" << endl;
+        exit(EXIT_FAILURE);
+    }
+    set_index_init(indexing, index_function, sized);
+    offset = __builtin_ctz(line_size);
+    indexes = indexing.direct ? indexing.bits : 0;
     tags = address_width - indexes - offset;
 
-    reads = START;
-    rd_miss = START;
-    writes = START;
-    wr_miss = START;
+    counters.reads = START;
+    counters.rd_miss = START;
+    counters.writes = START;
+    counters.wr_miss = START;
 
-    eviction = START;
-    access = START;
-    hits = START;
-    memory = START;
+    counters.eviction = START;
+    counters.hits = START;
+    counters.memory = START;
+    PROFILE_RESET(counters);
 
     number_memory_accesses = START;
-    table.clear();
-    table.resize(associativity);
-    // initialize associativity
+    index_shift = indexing.mask;
+    intervals = NULL;
+    resume = START;
+    resume_held = false;
+    memset(&resume_rest, 0, sizeof(resume_rest));
+    sampling = SAMPLING_OFF;
+    window_reads = window_writes = window_all = ratio_estimate_t();
+    window_measured = START;
+    sampled_trace = START;
+    sampled_fraction = 0;
+
+    if ((replacement == REPLACE_PLRU || replacement == REPLACE_SRRIP || replacement == REPLACE_BRRIP) && associativity > MAX_BIT_WAYS) {
+        cerr << replacement_name(replacement) << " replacement supports up to " << MAX_BIT_WAYS << " ways" << endl;
+        exit(EXIT_FAILURE);
+    }
+    if (replacement == REPLACE_PLRU && (associativity & (associativity - 1)) != 0) {
+        cerr << "plru replacement needs a power-of-two associativity" << endl;
+        exit(EXIT_FAILURE);
+    }
+    fully = NULL;
+    bool fully_associative = (sized == 1 && replacement == REPLACE_LRU);
+    if (associativity > 0xFFFF && !fully_associative) {
+        cerr << "associativity above " << 0xFFFF << " ways is not supported" << endl;
+        exit(EXIT_FAILURE);
+    }
 
+    // tags, replacement metadata (8-byte aligned so that every policy can use words), state
+    unsigned meta = (associativity > 1 && !fully_associative) ? replacement_bytes(replacement, associativity) : 0;
+    meta = (meta + sizeof(long long) - 1) / sizeof(long long) * sizeof(long long);
+    state_offset = associativity * sizeof(long long) + meta;
+    set_stride = block_stride(state_offset + associativity);
 
-    for(unsigned i = START; i < associativity; i++){
-        table[i].resize(sized);
+    // pages of a power-of-two number of sets, as many as fit in SPARSE_PAGE bytes
+    page_shift = START;
+    while ((2ULL << page_shift) * set_stride <= SPARSE_PAGE && (2ULL << page_shift) <= sized) {
+        page_shift++;
     }
-
-    for(unsigned i = START; i < indexes; i++){
-        index_shift <<= 1;
-        index_shift |= 1;
+    page_mask = (1ULL << page_shift) - 1;
+    page_bytes = (size_t)set_stride << page_shift;
+    page_count = (sized + page_mask) >> page_shift;
+    pages = (unsigned char **)calloc(page_count, sizeof(unsigned char *));
+    blocks = NULL;
+    blocks_bytes = START;
+    dense = NULL;
+    mapped = false;
+    if (pages == NULL) {
+        cerr << "cannot allocate the tag array directory (" << page_count << " pages)" << endl;
+        exit(EXIT_FAILURE);
     }
-    for(unsigned i = START; i < associativity; i++) {
-        for(unsigned j = START; j < offset; j++){
-            table[i][j].valid = START;
-            table[i][j].dirty = START;
-            table[i][j].tag = START;
-            table[i][j].index = START;
-            table[i][j].access_record = START;
+
+    size_t bytes = page_count * page_bytes;
+    if (bytes <= SPARSE_LIMIT || page_count == 1) {
+        if (posix_memalign((void **)&blocks, HOST_LINE, bytes) != 0) {
+            cerr << "cannot allocate the tag array (" << bytes << " bytes)" << endl;
+            exit(EXIT_FAILURE);
+        }
+        memset(blocks, 0, bytes);
+        blocks_bytes = bytes;
+        dense = blocks;
+        for (size_t p = START; p < page_count; p++) {
+            pages[p] = blocks + p * page_bytes;
+        }
+        if (associativity > 1 && !fully_associative) {
+            for (unsigned j = START; j < sized; j++) {
+                replacement_reset(replacement, set_meta(j), associativity, j);
+            }
         }
     }
+    if (fully_associative) {
+        fully = new tag_index(associativity, set_tags(0));
+    }
+
+    match = select_tag_match(associativity);
+    // sparse arrays take the generic engine, whose set_block materializes pages on first touch, and so do
+    // the indexing functions other than the direct mapping
+    select_kernel(fully ? FULLY_ASSOC : (dense && indexing.direct ? associativity : 0), line_size, wr_hit_policy, wr_miss_policy, kernel, shard_kernel, batch_kernel);
 }
 
 void cache::print_configuration() {
@@ -96,133 +167,348 @@ void cache::print_configuration() {
     cout << "cache hit time = " << hitT << " CLK" <<endl;
     cout << "cache miss penalty = " << penalty << " CLK" <<endl;
     cout << "memory address width = " << width << " bits" <<endl;
+    if (replacement != REPLACE_LRU) {
+        cout << "replacement policy = " << replacement_name(replacement) <<endl;
+    }
+    if (indexing.function != INDEX_MODULO || !indexing.direct) {
+        cout << "set indexing = " << index_function_name(indexing.function) << " (" << sized << " sets)" <<endl;
+    }
 }
 
 cache::~cache(){
-    table.clear();
-    eviction = START;
-    access = START;
-    reads = START;
-    rd_miss = START;
-    writes = START;
-    wr_miss = START;
-    hits = START;
+    close_interval_log();
+    delete fully;
+    fully = NULL;
+    release_pages();
+    free(pages);
+    pages = NULL;
+    counters.eviction = START;
+    counters.reads = START;
+    counters.rd_miss = START;
+    counters.writes = START;
+    counters.wr_miss = START;
+    counters.hits = START;
     number_memory_accesses = START;
 }
 
-void cache::load_trace(const char *filename){
-    stream.open(filename);
+void cache::load_trace(const char *filename, trace_mode_t mode){
+    if (!trace.open(filename, mode)){
+        cerr << "cannot open trace file " << filename << endl;
+        return;
+    }
+    resume_trace();
+}
+
+void cache::load_trace(trace_source *source){
+    if (!trace.open(source)){
+        cerr << "cannot allocate the workload buffer" << endl;
+        return;
+    }
+    resume_trace();
+}
+
+void cache::load_trace(const trace_entry_t *entries, size_t count){
+    trace.open(entries, count);
+    resume_trace();
+}
+
+void cache::resume_trace(){
+    if (resume == 0) return;
+    unsigned long long position = trace.position();
+    if (position > resume || trace.skip(resume - position) < resume - position) {
+        cerr << "the trace ends before the checkpoint position (" << resume << " accesses)" << endl;
+    }else if (resume_held) {
+        trace.hold(resume_rest);
+    }
+    resume = START;
+    resume_held = false;
 }
 
 void cache::run(unsigned num_entries){
+    if (intervals == NULL) {
+        (this->*kernel)(num_entries);
+        return;
+    }
+
+    // the kernel runs up to the next snapshot (or to the end of the request) at a time
     unsigned first_access = number_memory_accesses;
-    string line;
-    unsigned line_nr=START;
-    long long index;
-    long long x;
-
-    while (getline(stream,line)){
-        line_nr++;
-        char *str = const_cast<char*>(line.c_str());
-        char *op = strtok (str," ");
-        char *addr = strtok (NULL, " ");
-        address_t address = strtoull(addr, NULL, 16);
-
-        if (!strcmp(op, "w")) {
-            writes++;
-            if (write(address) == MISS) {
-                wr_miss++;
-                if(miss == WRITE_ALLOCATE){
-                    path = allocate(address);
-                    if(hit == WRITE_THROUGH){
-                        memory++;
-                    }else{
-                        index = (address >> offset) & index_shift;
-                        x = index % sized;
-                        table[path][x].dirty = 1;
-                    }
-                }else{
-                    memory++;
-                }
+    for (;;) {
+        unsigned chunk = intervals->remaining(number_memory_accesses);
+        if ((num_entries != 0) && chunk > num_entries - (number_memory_accesses - first_access)) {
+            chunk = num_entries - (number_memory_accesses - first_access);
+        }
+
+        unsigned before = number_memory_accesses;
+        (this->*kernel)(chunk);
+        if (number_memory_accesses - before < chunk) {
+            // the trace ended inside the interval
+            if (!intervals->recorded(number_memory_accesses)) intervals->record(snapshot(NULL, 0));
+            break;
+        }
+        if (intervals->remaining(number_memory_accesses) == 0) {
+            intervals->record(snapshot(NULL, 0));
+        }
+        if ((num_entries != 0) && (number_memory_accesses - first_access) == num_entries) break;
+    }
+}
+
+void cache::batch(const trace_entry_t *entries, const address_t *addresses, trace_op_t op, size_t count){
+    size_t done = START;
+    trace_entry_t cut[2];    // a run record crossing a snapshot: the part before it, then the rest
+    bool carrying = false;   // the rest is still to run, ahead of entries + done
+
+    while (done < count || carrying) {
+        const trace_entry_t *span = carrying ? &cut[1] : (entries ? entries + done : NULL);
+        size_t n = carrying ? 1 : count - done;
+
+        if (intervals != NULL) {
+            unsigned long long left = intervals->remaining(number_memory_accesses);
+            if (span == NULL) {
+                if (left < n) n = left;
             }else{
-                hits++;
-                if (hit == WRITE_THROUGH){
-                    memory++;
+                // whole entries up to the snapshot; a record crossing it runs in two parts
+                unsigned long long accesses = START;
+                size_t k = START;
+                while (k < n && accesses + trace_accesses(span[k]) <= left) {
+                    accesses += trace_accesses(span[k++]);
+                }
+                if (k == 0) {
+                    cut[0] = span[0];
+                    trace_cut(cut[0], left, cut[1]);
+                    (this->*batch_kernel)(&cut[0], NULL, op, 1);
+                    if (!carrying) done++;
+                    carrying = true;
+                    if (intervals->remaining(number_memory_accesses) == 0) {
+                        intervals->record(snapshot(NULL, 0));
+                    }
+                    continue;
                 }
+                n = k;
             }
         }
-        else if(!strcmp(op, "r")){
-            reads++;
-            if(read(address) == MISS) {
-                rd_miss++;
-                path = allocate(address);
-            }else{
-                hits++;
-            }
+
+        (this->*batch_kernel)(span, (span == NULL) ? addresses + done : NULL, op, n);
+        if (carrying) carrying = false;
+        else done += n;
+        if (intervals != NULL && intervals->remaining(number_memory_accesses) == 0) {
+            intervals->record(snapshot(NULL, 0));
         }
+    }
+}
+
+void cache::access_batch(const trace_entry_t *entries, size_t count){
+    batch(entries, NULL, TRACE_READ, count);
+}
 
-        access++;
-        number_memory_accesses++;
+void cache::read_batch(const address_t *addresses, size_t count){
+    batch(NULL, addresses, TRACE_READ, count);
+}
 
-        if ((num_entries!=0) && (number_memory_accesses - first_access) == num_entries) break;
+void cache::write_batch(const address_t *addresses, size_t count){
+    batch(NULL, addresses, TRACE_WRITE, count);
+}
+
+bool cache::set_interval_log(unsigned interval, const char *filename, interval_format_t format){
+    close_interval_log();
+
+    intervals = new interval_log();
+    if (!intervals->open(filename, interval, snapshot(NULL, 0), format)) {
+        cerr << "cannot open interval file " << filename << endl;
+        delete intervals;
+        intervals = NULL;
+        return false;
     }
+    return true;
 }
 
+void cache::close_interval_log(){
+    if (intervals == NULL) return;
+    if (!intervals->recorded(number_memory_accesses)) {
+        intervals->record(snapshot(NULL, 0));
+    }
+    delete intervals;
+    intervals = NULL;
+}
 
+interval_t cache::snapshot(const counters_t *shard, unsigned shards){
+    interval_t snapshot;
+
+    snapshot.accesses = number_memory_accesses;
+    snapshot.reads = counters.reads;
+    snapshot.rd_miss = counters.rd_miss;
+    snapshot.writes = counters.writes;
+    snapshot.wr_miss = counters.wr_miss;
+    snapshot.eviction = counters.eviction;
+    snapshot.memory = counters.memory;
+    for (unsigned w = START; w < shards; w++) {
+        snapshot.reads += shard[w].reads;
+        snapshot.rd_miss += shard[w].rd_miss;
+        snapshot.writes += shard[w].writes;
+        snapshot.wr_miss += shard[w].wr_miss;
+        snapshot.eviction += shard[w].eviction;
+        snapshot.memory += shard[w].memory;
+    }
+    return snapshot;
+}
 
 void cache::print_statistics() {
     cout << "STATISTICS" << endl;
     cout << "memory accesses = " << dec << number_memory_accesses << endl;
-    cout << "read = " << reads << endl;
-    cout << "read misses = " << rd_miss << endl;
-    cout << "write = " << writes << endl;
-    cout << "write misses = " << wr_miss << endl;
-    cout << "evictions = " << eviction << endl;
-    cout << "memory writes = " << dec << memory << endl;
-    cout << "average memory access time = " << float(penalty * ((float(rd_miss) + float(wr_miss)) / (number_memory_accesses)) + hitT) << endl;
+    cout << "read = " << counters.reads << endl;
+    cout << "read misses = " << counters.rd_miss << endl;
+    cout << "write = " << counters.writes << endl;
+    cout << "write misses = " << counters.wr_miss << endl;
+    cout << "evictions = " << counters.eviction << endl;
+    cout << "memory writes = " << dec << counters.memory << endl;
+    cout << "average memory access time = " << float(penalty * ((float(counters.rd_miss) + float(counters.wr_miss)) / (number_memory_accesses)) + hitT) << endl;
+
+    if (sampling != SAMPLING_OFF) {
+        sampling_stats_t estimate = get_sampling_statistics();
+        cout << "SAMPLING ESTIMATES (" << (sampling == SAMPLING_SETS ? "sets" : "time") << ", 95% confidence)" << endl;
+        cout << "trace accesses = " << estimate.trace_accesses << endl;
+        cout << "measured fraction = " << estimate.fraction << " (" << estimate.samples << " samples)" << endl;
+        cout << "read miss rate = " << estimate.read_miss_rate << " +/- " << estimate.read_miss_bound << endl;
+        cout << "write miss rate = " << estimate.write_miss_rate << " +/- " << estimate.write_miss_bound << endl;
+        cout << "miss rate = " << estimate.miss_rate << " +/- " << estimate.miss_bound << endl;
+        cout << "average memory access time = " << estimate.amat << " +/- " << estimate.amat_bound << endl;
+    }
+#ifdef CACHE_PROFILE
+    print_profile();
+#endif
 }
 
 
+profile_t cache::get_profile() {
+    profile_t profile = {};
+#ifdef CACHE_PROFILE
+    profile = counters.profile;
+#endif
+    return profile;
+}
+
+void cache::print_profile() {
+#ifdef CACHE_PROFILE
+    profile_print(counters.profile);
+#else
+    cout << "PROFILE" << endl << "not compiled in (build with make PROFILE=1)" << endl;
+#endif
+}
+
+cache_stats_t cache::get_statistics() {
+    cache_stats_t stats;
+
+    stats.accesses = number_memory_accesses;
+    stats.reads = counters.reads;
+    stats.rd_miss = counters.rd_miss;
+    stats.writes = counters.writes;
+    stats.wr_miss = counters.wr_miss;
+    stats.eviction = counters.eviction;
+    stats.memory = counters.memory;
+    stats.amat = float(penalty * ((float(counters.rd_miss) + float(counters.wr_miss)) / (number_memory_accesses)) + hitT);
+    return stats;
+}
+
 access_type_t cache::read(address_t address){
-    long long index;
+    unsigned long long x;
     long long tag;
-    long long x;
 
-    index = (address >> offset) & index_shift;
-    x = index % sized;
+    x = set_of(address);
     tag = address >> (offset + indexes);
 
-
-    for (unsigned i = START; i < coeval; i++) {
-        if ((table[i][x].valid) && (table[i][x].tag == tag)) {
-            table[i][x].access_record = access;
-            return HIT;
-        }
+    PROFILE_START(start);
+    int i = lookup<0>(x, tag);
+    PROFILE_STOP(counters, PROFILE_LOOKUP, start);
+    PROFILE_SCAN(counters, fully ? 1 : (i < 0) ? coeval : i + 1);
+    if (i >= 0) {
+        replace_hit(x, i);
+        return HIT;
     }
     return MISS;
 }
 
 access_type_t cache::write(address_t address){
-    long long index;
+    unsigned long long x;
     long long tag;
-    long long x;
 
-    index = (address >> offset) & index_shift;
-    x = index % sized;
+    x = set_of(address);
     tag = address >> (offset + indexes);
 
-    for (unsigned i = START; i < coeval; i++) {
-        if ((table[i][x].valid) && (table[i][x].tag == tag)) {
-            if(hit == WRITE_BACK){
-                table[i][x].dirty = 1;
-            }
-            table[i][x].access_record = access;
-            return HIT;
+    PROFILE_START(start);
+    int i = lookup<0>(x, tag);
+    PROFILE_STOP(counters, PROFILE_LOOKUP, start);
+    PROFILE_SCAN(counters, fully ? 1 : (i < 0) ? coeval : i + 1);
+    if (i >= 0) {
+        if(hit == WRITE_BACK){
+            set_state(x)[i] |= BLOCK_DIRTY;
         }
+        replace_hit(x, i);
+        return HIT;
     }
     return MISS;
 }
 
+void cache::set_tag_match(match_isa_t isa){
+    match = select_tag_match(coeval, isa);
+}
+
+unsigned char *cache::sparse_block(unsigned long long set){
+    unsigned char *page = __atomic_load_n(&pages[set >> page_shift], __ATOMIC_ACQUIRE);
+    if (page == NULL) page = materialize(set >> page_shift);
+    return page + (set & page_mask) * set_stride;
+}
+
+/*
+* A page starts with every way invalid and the replacement metadata of its sets reset, exactly as the
+* sets of a dense array start. Pages are only ever added, so a worker that loses the race for a page
+* frees its copy and takes the winner's.
+*/
+unsigned char *cache::materialize(size_t page){
+    unsigned char *block;
+
+    if (posix_memalign((void **)&block, HOST_LINE, page_bytes) != 0) {
+        cerr << "cannot allocate a page of the tag array (" << page_bytes << " bytes)" << endl;
+        exit(EXIT_FAILURE);
+    }
+    memset(block, 0, page_bytes);
+    if (coeval > 1 && fully == NULL) {
+        unsigned long long first = (unsigned long long)page << page_shift;
+        for (unsigned long long j = first; j < sized && j <= (first | page_mask); j++) {
+            replacement_reset(replacement, block + (j & page_mask) * set_stride + coeval * sizeof(long long), coeval, j);
+        }
+    }
+
+    unsigned char *expected = NULL;
+    if (!__atomic_compare_exchange_n(&pages[page], &expected, block, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(block);
+        return expected;
+    }
+    return block;
+}
+
+void cache::release_pages(){
+    for (size_t p = START; p < page_count; p++) {
+        unsigned char *page = pages[p];
+        if (page != NULL && !(page >= blocks && page < blocks + blocks_bytes)) free(page);
+        pages[p] = NULL;
+    }
+    if (mapped) munmap(blocks, blocks_bytes);
+    else free(blocks);
+    blocks = NULL;
+    blocks_bytes = START;
+    dense = NULL;
+    mapped = false;
+}
+
+unsigned long long cache::populated_sets(){
+    unsigned long long sets = START;
+    for (size_t p = START; p < page_count; p++) {
+        if (pages[p] == NULL) continue;
+        unsigned long long first = (unsigned long long)p << page_shift;
+        sets += (sized - first < page_mask + 1) ? sized - first : page_mask + 1;
+    }
+    return sets;
+}
+
 void cache::print_tag_array(){
 
     cout << "TAG ARRAY" << endl;
@@ -232,16 +518,25 @@ void cache::print_tag_array(){
         if (hit != WRITE_BACK) {
             cout << setfill(' ') << setw(7) << "index" << setw(6) << setw(4 + tags/4) << "tag" <<endl;
             for (unsigned j = START; j < sized; j++) {
-                if (table[i][j].valid == 1) {
-                    cout << setfill(' ') << setw(7) << dec << table[i][j].index << setw(4) << "0x" << hex << table[i][j].tag <<endl;
+                if (pages[j >> page_shift] == NULL) {
+                    j |= page_mask;
+                    continue;
+                }
+                if (set_state(j)[i] & BLOCK_VALID) {
+                    cout << setfill(' ') << setw(7) << dec << j << setw(4) << "0x" << hex << set_tags(j)[i] <<endl;
                 }
             }
 
         }else{
             cout << setfill(' ') << setw(7) << "index" << setw(6) << "dirty" << setw(4 + tags/4) << "tag" <<endl;
             for (unsigned k = START; k < sized; k++) {
-                if (table[i][k].valid == 1) {
-                    cout << setfill(' ') << setw(7) << dec << table[i][k].index << setw(6) << dec << table[i][k].dirty << setw(4) << "0x" << hex << table[i][k].tag <<endl;
+                if (pages[k >> page_shift] == NULL) {
+                    k |= page_mask;
+                    continue;
+                }
+                unsigned char state = set_state(k)[i];
+                if (state & BLOCK_VALID) {
+                    cout << setfill(' ') << setw(7) << dec << k << setw(6) << dec << ((state & BLOCK_DIRTY) ? 1 : 0) << setw(4) << "0x" << hex << set_tags(k)[i] <<endl;
                 }
             }
         }
@@ -249,52 +544,80 @@ void cache::print_tag_array(){
 }
 
 unsigned cache::evict(long long index) {
-    unsigned least = START;
-    unsigned record = access;
-
-    for (unsigned i = START; i < coeval; i++) {
-        if (record >= table[i][index].access_record) {
-            least = i;
-            record = table[i][index].access_record;
-        }
-    }
-    return least;
+    PROFILE_START(start);
+    unsigned way = victim<0>(index);
+    PROFILE_STOP(counters, PROFILE_EVICT, start);
+    return way;
 }
 
 unsigned cache::allocate(address_t address) {
-    long long index;
+    unsigned long long x;
     long long tag;
-    long long j;
 
-    index = ((address >> offset) & index_shift);
-    j = (index % sized);
+    x = set_of(address);
+    tag = address >> (offset + indexes);
 
-    unsigned evicter = evict(j);
-    tag = address >> (indexes+offset);
+    PROFILE_START(start);
+    unsigned way = fill<0>(x, tag, counters);
+    PROFILE_STOP(counters, PROFILE_ALLOCATE, start);
+    return way;
+}
 
+int cache::probe(address_t address) {
+    unsigned long long x = set_of(address);
+    long long tag = address >> (offset + indexes);
 
-    for (unsigned i = START; i < coeval; i++) {
-        if (table[i][j].valid == START) {
-            table[i][j].access_record = access;
-            table[i][j].tag = tag;
+    return lookup<0>(x, tag);
+}
 
-            table[i][j].valid = 1;
-            table[i][j].index = index;
+void cache::touch(address_t address, unsigned way, bool dirty) {
+    unsigned long long x = set_of(address);
 
-            return i;
-        }
+    replace_hit(x, way);
+    if (dirty) {
+        set_state(x)[way] |= BLOCK_DIRTY;
     }
-    eviction++;
-    if (table[evicter][j].dirty == 1) {
-        table[evicter][j].dirty = START;
-        memory++;
+}
+
+bool cache::install(address_t address, bool dirty, address_t &victim_address, bool &victim_dirty) {
+    unsigned long long x = set_of(address);
+    long long tag = address >> (offset + indexes);
+    long long *way_tag = set_tags(x);
+    unsigned char *state = set_state(x);
+    int empty = first_invalid<0>(x);
+    bool evicted = (empty < 0);
+    unsigned way = evicted ? victim<0>(x) : empty;
+
+    if (evicted) {
+        victim_address = block_address(x, way_tag[way]);
+        victim_dirty = (state[way] & BLOCK_DIRTY) != 0;
+        replace_remove(way, false);
     }
 
-    table[evicter][j].index = index;
-    table[evicter][j].access_record = access;
+    way_tag[way] = tag;
+    state[way] = BLOCK_VALID | (dirty ? BLOCK_DIRTY : 0);
+    replace_insert(x, way);
+    return evicted;
+}
 
-    table[evicter][j].tag = tag;
+bool cache::invalidate(address_t address, bool &dirty) {
+    unsigned long long x = set_of(address);
+    long long tag = address >> (offset + indexes);
+    int way = lookup<0>(x, tag);
 
-    return evicter;
+    if (way < 0) return false;
+    dirty = (set_state(x)[way] & BLOCK_DIRTY) != 0;
+    replace_remove(way, true);
+    set_state(x)[way] = START;
+    return true;
 }
 
+bool cache::clean(address_t address) {
+    unsigned long long x = set_of(address);
+    long long tag = address >> (offset + indexes);
+    int way = lookup<0>(x, tag);
+
+    if (way < 0 || !(set_state(x)[way] & BLOCK_DIRTY)) return false;
+    set_state(x)[way] &= ~BLOCK_DIRTY;
+    return true;
+}
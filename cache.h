@@ -8,6 +8,15 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include "trace.h"
+#include "tag_match.h"
+#include "replacement.h"
+#include "set_index.h"
+#include "tag_index.h"
+#include "interval.h"
+#include "sampling.h"
+#include "export.h"
+#include "profile.h"
 
 using namespace std;
 
@@ -18,23 +27,63 @@ typedef enum {WRITE_BACK, WRITE_THROUGH, WRITE_ALLOCATE, NO_WRITE_ALLOCATE} writ
 
 typedef enum {HIT, MISS} access_type_t;
 
-typedef long long address_t; //memory address type
+/* execution counters (one set per worker in sharded runs) */
+typedef struct{
+    unsigned reads;
+    unsigned rd_miss;
+
+    unsigned writes;
+    unsigned wr_miss;
+
+    unsigned eviction;
+    unsigned hits;
+    unsigned memory;
+
+#ifdef CACHE_PROFILE
+    profile_t profile;
+#endif
+} counters_t;
 
+/* execution statistics, as printed by print_statistics */
 typedef struct{
-    long long index;
-    long long tag;
-    unsigned valid;
-    unsigned dirty;
-    unsigned access_record;
-} cachee_t;
+    unsigned long long accesses;
+    unsigned long long reads;
+    unsigned long long rd_miss;
+    unsigned long long writes;
+    unsigned long long wr_miss;
+    unsigned long long eviction;
+    unsigned long long memory;
+    float amat;
+} cache_stats_t;
+
+/* per-way state bits of the tag array */
+#define BLOCK_VALID 0x1
+#define BLOCK_DIRTY 0x2
+
+#define HOST_LINE 64 //host cache line size used to lay out the tag array
+
+#define SPARSE_PAGE 4096 //bytes of set blocks per page of the tag array (at least one set)
+#define SPARSE_LIMIT (1 << 24) //largest tag array allocated whole; larger ones are materialized lazily
+
+#define FULLY_ASSOC 0xFFFFFFFFu //engine associativity of fully-associative caches (see tag_index.h)
+
+// bytes per set block of "block" bytes: blocks smaller than a host line are padded to a power of two so
+// that they tile host lines exactly, larger ones are padded to whole host lines
+constexpr unsigned block_stride(unsigned block){
+    unsigned stride = sizeof(long long);
+    while (stride < block && stride < HOST_LINE) {
+        stride <<= 1;
+    }
+    return (stride < block) ? (block + HOST_LINE - 1) / HOST_LINE * HOST_LINE : stride;
+}
 
 class cache{
 
     /* number of memory accesses processed */
     unsigned number_memory_accesses;
 
-    /* trace file input stream */
-    ifstream stream;
+    /* trace file reader */
+    trace_reader trace;
 
     /* cache intermediary parameter holders*/
     unsigned cache_size;
@@ -52,21 +101,191 @@ class cache{
     unsigned indexes;
     unsigned tags;
 
-    unsigned index_shift;
-    unsigned path;
+    /*
+    * set indexing (set_index.h); with the direct mapping (INDEX_MODULO over a power-of-two number of
+    * sets) the set is (address >> offset) & index_shift and the tag address >> (offset + indexes),
+    * otherwise the set comes from set_index_of and the tag is the line address (indexes is 0)
+    */
+    set_index_t indexing;
+    unsigned long long index_shift;
+
+    // set of "address"
+    unsigned long long set_of(address_t address){
+        if (__builtin_expect(indexing.direct, 1)) return (address >> offset) & index_shift;
+        return set_index_of(indexing, address >> offset);
+    }
+
+    /*
+    * tag array: set-major, with one block of "set_stride" bytes per set
+    * each block holds the tags of all ways, then the replacement metadata of the set (replacement.h,
+    * none for direct-mapped caches), then the state bits of the ways
+    * so a lookup touches only the one or two host cache lines of its set
+    * the blocks are grouped in pages of 2^page_shift sets reached through the "pages" directory; arrays up
+    * to SPARSE_LIMIT bytes get all their pages at once, larger ones materialize a page on its first touch
+    */
+    unsigned char **pages;
+    size_t page_count;
+    unsigned page_shift;
+    unsigned long long page_mask;
+    size_t page_bytes;
+    unsigned set_stride;
+    unsigned state_offset;
+
+    /* storage holding consecutive pages in one piece (dense arrays, checkpoints), NULL when there is none */
+    unsigned char *blocks;
+    size_t blocks_bytes;
+
+    /* "blocks" when it holds every page in order (set blocks then sit at set * set_stride), NULL otherwise */
+    unsigned char *dense;
+
+    /* true when "blocks" is the checkpoint mapping made by load_state (false: allocated) */
+    bool mapped;
+
+    // block of "set" in a sparse array, materializing its page on first touch
+    unsigned char *sparse_block(unsigned long long set);
+
+    // allocates page "page" with empty sets; workers of a parallel run may race on it and all get the same one
+    unsigned char *materialize(size_t page);
+
+    // frees every page and the storage behind them, leaving an empty directory
+    void release_pages();
+
+    /* trace position to resume from after load_state, applied to the trace loaded next, and what was
+       left there of a cut run record (when "resume_held") */
+    unsigned long long resume;
+    trace_entry_t resume_rest;
+    bool resume_held;
+
+    // skips the loaded trace to the "resume" position
+    void resume_trace();
+
+    /* replacement policy */
+    replacement_policy_t replacement;
+
+    /* hashed lookup and LRU list of fully-associative caches (single set, LRU), NULL otherwise */
+    tag_index *fully;
+
+    /*
+    * ASSOC != 0 turns the associativity (and so the block layout) into a compile-time constant;
+    * FULLY_ASSOC selects the hashed operations of fully-associative caches, which ASSOC = 0 picks at runtime
+    */
+    template <unsigned ASSOC=0> unsigned ways(){
+        return (ASSOC && ASSOC != FULLY_ASSOC) ? ASSOC : coeval;
+    }
+
+    template <unsigned ASSOC=0> bool is_fully(){
+        return ASSOC == FULLY_ASSOC || (ASSOC == 0 && fully != NULL);
+    }
+
+    template <unsigned ASSOC=0> unsigned char *set_block(unsigned long long set){
+        // the specialized engines only run on dense arrays (see the constructor)
+        if (ASSOC != 0 || __builtin_expect(dense != NULL, 1)) return dense + set * set_stride;
+        return sparse_block(set);
+    }
+
+    template <unsigned ASSOC=0> long long *set_tags(unsigned long long set){
+        return (long long *)set_block<ASSOC>(set);
+    }
+
+    template <unsigned ASSOC=0> unsigned char *set_meta(unsigned long long set){
+        return set_block<ASSOC>(set) + ways<ASSOC>() * sizeof(long long);
+    }
+
+    template <unsigned ASSOC=0> unsigned char *set_state(unsigned long long set){
+        return set_block<ASSOC>(set) + state_offset;
+    }
+
+    /* replacement hooks; a direct-mapped set has nothing to choose from */
+    template <unsigned ASSOC=0> void replace_hit(unsigned long long set, unsigned way){
+        if (is_fully<ASSOC>()) fully->touch(way);
+        else if (ways<ASSOC>() > 1) replacement_hit(replacement, set_meta<ASSOC>(set), ways<ASSOC>(), way);
+    }
+
+    // "way" has just received its new tag
+    template <unsigned ASSOC=0> void replace_insert(unsigned long long set, unsigned way){
+        if (is_fully<ASSOC>()) fully->insert(way);
+        else if (ways<ASSOC>() > 1) replacement_insert(replacement, set_meta<ASSOC>(set), ways<ASSOC>(), way);
+    }
+
+    // the valid "way" is about to lose its tag (to a new one, or for good when "release")
+    template <unsigned ASSOC=0> void replace_remove(unsigned way, bool release){
+        if (is_fully<ASSOC>()) fully->remove(way, release);
+    }
+
+    /* way-parallel tag comparison for one set */
+    tag_match_t match;
+
+    /*
+    * access engine (engine.h): the simulation loop is a template over associativity, line size and
+    * write policies; the constructor picks a pre-instantiated specialization or the generic one
+    */
+    typedef void (cache::*kernel_t)(unsigned num_entries);
+    kernel_t kernel;
+
+    /* sharded engine: simulates the accesses "list" (indices into "chunk") of one worker's sets */
+    typedef void (cache::*shard_kernel_t)(const trace_entry_t *chunk, const unsigned *list, size_t count, counters_t &shard);
+    shard_kernel_t shard_kernel;
+
+    /* batch engine: simulates accesses handed over in an array (see access_batch) */
+    typedef void (cache::*batch_kernel_t)(const trace_entry_t *entries, const address_t *addresses, trace_op_t op, size_t count);
+    batch_kernel_t batch_kernel;
+
+    static void select_kernel(unsigned associativity, unsigned line_size, write_policy_t wr_hit_policy, write_policy_t wr_miss_policy,
+                              kernel_t &kernel, shard_kernel_t &shard_kernel, batch_kernel_t &batch_kernel);
+
+    /* "count" is the set of counters charged with the access */
+    template <unsigned ASSOC> int lookup(unsigned long long set, long long tag);
+    template <unsigned ASSOC> int first_invalid(unsigned long long set);
+    template <unsigned ASSOC> unsigned victim(unsigned long long set);
+    template <unsigned ASSOC> unsigned fill(unsigned long long set, long long tag, counters_t &count);
+    template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS> void step(const trace_entry_t &entry, counters_t &count);
+    template <unsigned ASSOC, write_policy_t HIT, write_policy_t MISS> int step_at(unsigned long long set, long long tag, trace_op_t op, counters_t &count);
+    template <unsigned ASSOC, write_policy_t HIT> void fold(unsigned long long set, int way, unsigned reads, unsigned writes, counters_t &count);
+    template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS> void run_kernel(unsigned num_entries);
+    template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS> void run_shard(const trace_entry_t *chunk, const unsigned *list, size_t count, counters_t &shard);
+    template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS> void run_batch(const trace_entry_t *entries, const address_t *addresses, trace_op_t op, size_t count);
+
+    // splits a batch at interval snapshots and hands it to the batch engine
+    void batch(const trace_entry_t *entries, const address_t *addresses, trace_op_t op, size_t count);
+
+    // caches own their tag array and are not copied
+    cache(const cache &);
+    cache &operator=(const cache &);
 
     /* Add the data members required by your simulator's implementation here */
-    unsigned reads;
-    unsigned rd_miss;
+    counters_t counters;
 
-    unsigned writes;
-    unsigned wr_miss;
+    /* time series of the counters, NULL when off */
+    interval_log *intervals;
 
-    unsigned eviction;
-    unsigned access;
+    // the counters as an interval snapshot, adding "shards" worker counters not merged yet
+    interval_t snapshot(const counters_t *shard, unsigned shards);
 
-    unsigned hits;
-    unsigned memory;
+    /* sampled runs (sampling.h): counters of every cluster of sets, running estimates over the windows
+       (so that time sampling keeps no per-window state), accesses taken from the trace */
+    sampling_mode_t sampling;
+    vector<counters_t> samples;
+    ratio_estimate_t window_reads;
+    ratio_estimate_t window_writes;
+    ratio_estimate_t window_all;
+    unsigned long long window_measured;
+    unsigned long long sampled_trace;
+    double sampled_fraction;
+
+    // starts (or continues) a sampled run in "mode"
+    void begin_sampling(sampling_mode_t mode);
+
+    // adds the counters of the measured accesses to the statistics
+    void merge_samples(const counters_t &measured, unsigned long long accesses);
+
+    // rebuilds the block address of "tag" in "set"
+    address_t block_address(unsigned long long set, long long tag){
+        return (address_t)(((unsigned long long)tag << (offset + indexes)) | (indexing.direct ? set << offset : 0));
+    }
+
+    // multi-level hierarchies and multi-core systems read the policies, timings and geometry of their caches
+    friend class hierarchy;
+    friend class multicore;
 
 public:
 
@@ -74,31 +293,87 @@ public:
     * Instantiates the cache simulator
         */
     cache(unsigned cache_size, 		// cache size (in bytes)
-          unsigned cache_associativity,     // cache associativity (fully-associative caches not considered)
+          unsigned cache_associativity,     // cache associativity (0 or size/line size: fully-associative)
           unsigned cache_line_size,         // cache block size (in bytes)
           write_policy_t write_hit_policy,  // write-back or write-through
           write_policy_t write_miss_policy, // write-allocate or no-write-allocate
           unsigned cache_hit_time,		// cache hit time (in clock cycles)
           unsigned cache_miss_penalty,	// cache miss penalty (in clock cycles)
-          unsigned address_width            // number of bits in memory address
+          unsigned address_width,           // number of bits in memory address
+          replacement_policy_t replacement_policy=REPLACE_LRU, // victim selection of full sets
+          index_function_t index_function=INDEX_MODULO        // mapping of lines to sets
     );
 
     // de-allocates the cache simulator
     ~cache();
 
     // loads the trace file (with name "filename") so that it can be used by the "run" function
-    void load_trace(const char *filename);
+    // TRACE_MMAP (default) maps the file and parses it in place, TRACE_STREAM reads it through a buffer,
+    // TRACE_PIPELINE decodes it ahead on helper threads; gzip/zstd compressed files are decompressed while reading
+    void load_trace(const char *filename, trace_mode_t mode=TRACE_MMAP);
+
+    // reads the accesses generated by "source" (e.g. a workload), which must outlive the run
+    void load_trace(trace_source *source);
+
+    // uses "count" accesses already decoded in memory as the trace; the array is shared, not copied
+    void load_trace(const trace_entry_t *entries, size_t count);
+
+    // writes the warmed-up state (tag array with its replacement metadata, counters and trace position)
+    // to "filename", in a binary layout whose tag array can be mapped back as is
+    bool save_state(const char *filename);
+
+    // restores a state written by save_state from a cache of the same configuration; the tag array
+    // is mapped copy-on-write from the file, and the trace (loaded now or next) resumes where it was
+    bool load_state(const char *filename);
 
     // processes "num_memory_accesses" memory accesses (i.e., entries) from the input trace
     // if "num_memory_accesses=0" (default), then it processes the trace to completion
+    // text lines whose op is neither r nor w are skipped (trace.h): they count neither as memory
+    // accesses nor toward "num_memory_accesses"
+    // run records (runs.h) count as all the accesses they fold, and are cut where the count ends
     void run(unsigned num_memory_accesses=0);
 
+    // same as run, with the sets split into "threads" contiguous ranges each simulated by its own thread
+    // statistics and tag array are identical to the serial run
+    void run_parallel(unsigned threads, unsigned num_memory_accesses=0);
+
+    // simulates only about one set in "ratio" (picked pseudo-randomly among the sets) and skips the
+    // accesses to the others; the statistics then cover the sampled sets and print_statistics adds the
+    // estimated miss rates and AMAT with their confidence bounds
+    void run_sampled_sets(unsigned ratio, unsigned num_memory_accesses=0);
+
+    // splits the trace into periods of "period" accesses: skips the start of each period, simulates
+    // "warmup" accesses without counting them, then measures the last "window" ones; estimates as above
+    void run_sampled_time(unsigned period, unsigned window, unsigned warmup, unsigned num_memory_accesses=0);
+
+    // returns the estimates of the sampled runs (mode SAMPLING_OFF when there was none)
+    sampling_stats_t get_sampling_statistics();
+
+    // from now on, snapshots the counters every "interval" accesses processed by run/run_parallel and
+    // writes them to "filename" from a background thread (formats in interval.h); the sampled runs only
+    // count part of the trace and refuse to run while the log is open
+    bool set_interval_log(unsigned interval, const char *filename, interval_format_t format=INTERVAL_CSV);
+
+    // records the current partial interval, if any, writes out the pending snapshots and stops logging
+    void close_interval_log();
+
+    // processes "count" entries from memory (plain accesses or run records, see runs.h) exactly as run()
+    // processes trace entries (allocation, dirty tracking, statistics), without the per-call overhead of read/write
+    void access_batch(const trace_entry_t *entries, size_t count);
+
+    // same as access_batch, with reads (resp. writes) of every address in "addresses"
+    void read_batch(const address_t *addresses, size_t count);
+    void write_batch(const address_t *addresses, size_t count);
+
     // processes a read operation and returns hit/miss
     access_type_t read(address_t address);
 
     // processes a write operation and returns hit/miss
     access_type_t write(address_t address);
 
+    // selects the tag comparison used by read/write (MATCH_AUTO picks the widest SIMD the host supports)
+    void set_tag_match(match_isa_t isa);
+
     // returns the next block to be evicted from the cache
     unsigned evict(long long index);
 
@@ -108,10 +383,46 @@ public:
     // prints the execution statistics
     void print_statistics();
 
+    // returns the execution statistics
+    cache_stats_t get_statistics();
+
+    // returns the hot-path profile (profile.h), all zero unless built with CACHE_PROFILE
+    profile_t get_profile();
+
+    // prints the hot-path profile (print_statistics does too in CACHE_PROFILE builds)
+    void print_profile();
+
     //prints the metadata information (including "dirty" but, when applicable) for all valid cache entries
     void print_tag_array();
 
+    // writes the valid entries of the tag array (set, way, dirty bit, tag, block address) to "filename"
+    // as CSV, JSON lines or binary records (export.h), in large buffered writes
+    bool export_tag_array(const char *filename, export_format_t format=EXPORT_CSV);
+
+    // writes the execution statistics (as returned by get_statistics) to "filename" the same way
+    bool export_statistics(const char *filename, export_format_t format=EXPORT_CSV);
+
+    // returns the number of sets whose block is allocated (all of them unless the array is sparse)
+    unsigned long long populated_sets();
+
     unsigned int allocate(address_t address);
+
+    /* building blocks for multi-level hierarchies: tag array operations that count no statistics */
+
+    // returns the way holding "address", or -1 when it is not cached
+    int probe(address_t address);
+
+    // marks the block of "address" in "way" as most recently used (and dirty when "dirty")
+    void touch(address_t address, unsigned way, bool dirty);
+
+    // allocates "address"; returns true when a valid block was evicted, reporting its address and dirty bit
+    bool install(address_t address, bool dirty, address_t &victim, bool &victim_dirty);
+
+    // removes "address"; returns true when it was cached, reporting its dirty bit
+    bool invalidate(address_t address, bool &dirty);
+
+    // clears the dirty bit of "address" without touching its recency; returns true when it was dirty
+    bool clean(address_t address);
 };
 
 #endif /*CACHE_H_*/
\ No newline at end of file
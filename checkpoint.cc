@@ -0,0 +1,282 @@
+#include "cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+#define START 0x0
+
+/*
+* Checkpoint layout: a fixed header, then the numbers of the tag array pages that are populated, then
+* those pages exactly as they sit in memory (tags, replacement metadata and state of every set block)
+* one after the other, starting at a page boundary so that load_state can map them copy-on-write
+* instead of reading them, then the tag_index state of fully-associative caches.
+* The layout is that of the host that wrote it (byte order, set block layout); the header records
+* enough of it to refuse a mismatch.
+*/
+#define STATE_MAGIC "CSTA"
+#define STATE_VERSION 4
+
+typedef struct{
+    char magic[4];
+    uint32_t version;
+
+    /* configuration */
+    uint32_t size;
+    uint32_t associativity;
+    uint32_t line;
+    uint32_t hit_policy;
+    uint32_t miss_policy;
+    uint32_t hit_time;
+    uint32_t penalty;
+    uint32_t width;
+    uint32_t replacement;
+    uint32_t index_function;
+
+    /* tag array layout */
+    uint32_t sets;
+    uint32_t set_stride;
+    uint32_t state_offset;
+
+    /* counters and trace position */
+    uint32_t reads;
+    uint32_t rd_miss;
+    uint32_t writes;
+    uint32_t wr_miss;
+    uint32_t eviction;
+    uint32_t hits;
+    uint32_t memory;
+    uint32_t page_shift;
+    uint64_t accesses;
+    uint64_t trace_position;
+
+    /* rest of the run record cut at the trace position (runs.h), when "resting" is 1 */
+    uint32_t resting;
+    uint32_t rest_op;
+    uint32_t rest_core;
+    uint32_t rest_reads;
+    uint32_t rest_writes;
+    uint32_t rest_unused;
+    uint64_t rest_address;
+
+    /* sections (byte offsets in the file) */
+    uint64_t pages;
+    uint64_t pages_offset;
+    uint64_t blocks_offset;
+    uint64_t blocks_bytes;
+    uint64_t index_offset;
+    uint64_t index_bytes;
+} state_header_t;
+
+static bool write_all(int fd, const void *data, size_t bytes){
+    const char *p = (const char *)data;
+    while (bytes > 0) {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n <= 0) return false;
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+bool cache::save_state(const char *filename){
+    state_header_t header;
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STATE_MAGIC, 4);
+    header.version = STATE_VERSION;
+    header.size = cache_size;
+    header.associativity = coeval;
+    header.line = lsize;
+    header.hit_policy = hit;
+    header.miss_policy = miss;
+    header.hit_time = hitT;
+    header.penalty = penalty;
+    header.width = width;
+    header.replacement = replacement;
+    header.index_function = indexing.function;
+    header.sets = sized;
+    header.set_stride = set_stride;
+    header.state_offset = state_offset;
+    header.reads = counters.reads;
+    header.rd_miss = counters.rd_miss;
+    header.writes = counters.writes;
+    header.wr_miss = counters.wr_miss;
+    header.eviction = counters.eviction;
+    header.hits = counters.hits;
+    header.memory = counters.memory;
+    header.accesses = number_memory_accesses;
+    header.trace_position = resume ? resume : trace.position();
+    trace_entry_t rest = resume_rest;
+    bool resting = resume ? resume_held : trace.pending(rest);
+    if (resting) {
+        header.resting = 1;
+        header.rest_op = rest.op;
+        header.rest_core = rest.core;
+        header.rest_reads = rest.reads;
+        header.rest_writes = rest.writes;
+        header.rest_address = rest.address;
+    }
+    header.page_shift = page_shift;
+
+    vector<uint64_t> saved;
+    for (size_t p = START; p < page_count; p++) {
+        if (pages[p] != NULL) saved.push_back(p);
+    }
+    header.pages = saved.size();
+    header.pages_offset = sizeof(header);
+    header.blocks_offset = (header.pages_offset + saved.size() * sizeof(uint64_t) + page - 1) / page * page;
+    header.blocks_bytes = (uint64_t)saved.size() * page_bytes;
+    header.index_offset = header.blocks_offset + header.blocks_bytes;
+    header.index_bytes = fully ? fully->state_bytes() : 0;
+
+    int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "cannot create state file " << filename << endl;
+        return false;
+    }
+
+    vector<unsigned char> padding(header.blocks_offset - header.pages_offset - saved.size() * sizeof(uint64_t), 0);
+    vector<unsigned char> index(header.index_bytes);
+    if (fully) fully->save(index.data());
+
+    bool ok = write_all(fd, &header, sizeof(header)) && write_all(fd, saved.data(), saved.size() * sizeof(uint64_t))
+           && write_all(fd, padding.data(), padding.size());
+
+    // pages adjacent in memory (all of them in a dense array) go out in one write
+    for (size_t k = START; ok && k < saved.size();) {
+        unsigned char *run = pages[saved[k]];
+        size_t count = 1;
+        while (k + count < saved.size() && pages[saved[k + count]] == run + count * page_bytes) {
+            count++;
+        }
+        ok = write_all(fd, run, count * page_bytes);
+        k += count;
+    }
+    ok = ok && write_all(fd, index.data(), index.size());
+    ok = (::close(fd) == 0) && ok;
+    if (!ok) cerr << "cannot write state file " << filename << endl;
+    return ok;
+}
+
+bool cache::load_state(const char *filename){
+    struct stat info;
+    state_header_t header;
+
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+        cerr << "cannot open state file " << filename << endl;
+        return false;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(header) || pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        cerr << "cannot read state file " << filename << endl;
+        ::close(fd);
+        return false;
+    }
+
+    bool same = !memcmp(header.magic, STATE_MAGIC, 4) && header.version == STATE_VERSION;
+    if (!same) {
+        cerr << filename << " is not a cache state file" << endl;
+        ::close(fd);
+        return false;
+    }
+    same = header.size == cache_size && header.associativity == coeval && header.line == lsize
+        && header.hit_policy == (uint32_t)hit && header.miss_policy == (uint32_t)miss && header.hit_time == hitT
+        && header.penalty == penalty && header.width == width && header.replacement == (uint32_t)replacement
+        && header.index_function == (uint32_t)indexing.function
+        && header.sets == sized && header.set_stride == set_stride && header.state_offset == state_offset
+        && header.page_shift == page_shift && header.pages <= page_count
+        && (header.pages == page_count || page_count * page_bytes > SPARSE_LIMIT)
+        && header.blocks_bytes == header.pages * page_bytes && header.index_bytes == (fully ? fully->state_bytes() : 0)
+        && header.index_offset + header.index_bytes <= (uint64_t)info.st_size
+        && header.pages_offset + header.pages * sizeof(uint64_t) <= header.blocks_offset
+        && header.blocks_offset + header.blocks_bytes <= header.index_offset;
+    if (!same) {
+        cerr << "state file " << filename << " was saved by a cache of another configuration" << endl;
+        ::close(fd);
+        return false;
+    }
+
+    vector<uint64_t> saved(header.pages);
+    vector<unsigned char> index(header.index_bytes);
+    if (pread(fd, saved.data(), saved.size() * sizeof(uint64_t), header.pages_offset) != (ssize_t)(saved.size() * sizeof(uint64_t))
+        || pread(fd, index.data(), index.size(), header.index_offset) != (ssize_t)index.size()) {
+        cerr << "cannot read state file " << filename << endl;
+        ::close(fd);
+        return false;
+    }
+    for (size_t k = START; k < saved.size(); k++) {
+        if (saved[k] >= page_count || (k > 0 && saved[k] <= saved[k - 1])) {
+            cerr << "state file " << filename << " is corrupt" << endl;
+            ::close(fd);
+            return false;
+        }
+    }
+
+    // the pages are mapped copy-on-write where the file allows it, and read otherwise
+    size_t page = sysconf(_SC_PAGESIZE);
+    unsigned char *region = NULL;
+    bool map = false;
+    if (header.blocks_bytes > 0 && header.blocks_offset % page == 0) {
+        void *at = mmap(NULL, header.blocks_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, header.blocks_offset);
+        if (at != MAP_FAILED) {
+            region = (unsigned char *)at;
+            map = true;
+        }
+    }
+    if (!map && header.blocks_bytes > 0) {
+        if (posix_memalign((void **)&region, HOST_LINE, header.blocks_bytes) != 0
+            || pread(fd, region, header.blocks_bytes, header.blocks_offset) != (ssize_t)header.blocks_bytes) {
+            cerr << "cannot read state file " << filename << endl;
+            free(region);
+            ::close(fd);
+            return false;
+        }
+    }
+
+    ::close(fd);
+
+    // the sets left out of the file start empty again when touched
+    release_pages();
+    blocks = region;
+    blocks_bytes = header.blocks_bytes;
+    mapped = map;
+    for (size_t k = START; k < saved.size(); k++) {
+        pages[saved[k]] = region + k * page_bytes;
+    }
+    if (saved.size() == page_count) dense = region;
+
+    if (fully) {
+        // the index follows the tag array to its new place
+        delete fully;
+        fully = new tag_index(coeval, set_tags(0));
+        fully->load(index.data());
+    }
+
+    counters.reads = header.reads;
+    counters.rd_miss = header.rd_miss;
+    counters.writes = header.writes;
+    counters.wr_miss = header.wr_miss;
+    counters.eviction = header.eviction;
+    counters.hits = header.hits;
+    counters.memory = header.memory;
+    number_memory_accesses = header.accesses;
+
+    resume = header.trace_position;
+    resume_held = (header.resting != 0);
+    if (resume_held) {
+        resume_rest.address = header.rest_address;
+        resume_rest.op = (trace_op_t)header.rest_op;
+        resume_rest.core = header.rest_core;
+        resume_rest.reads = header.rest_reads;
+        resume_rest.writes = header.rest_writes;
+    }
+    if (trace.is_open()) resume_trace();
+    return true;
+}
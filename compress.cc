@@ -0,0 +1,282 @@
+#include "compress.h"
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define START 0x0
+
+compression_t detect_compression(const unsigned char *bytes, size_t size){
+    if (size >= 2 && bytes[0] == 0x1F && bytes[1] == 0x8B) return COMPRESSION_GZIP;
+    if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xB5 && bytes[2] == 0x2F && bytes[3] == 0xFD) return COMPRESSION_ZSTD;
+    return COMPRESSION_NONE;
+}
+
+const char *compression_name(compression_t kind){
+    switch (kind) {
+        case COMPRESSION_GZIP: return "gzip";
+        case COMPRESSION_ZSTD: return "zstd";
+        default: return "none";
+    }
+}
+
+bool compression_supported(compression_t kind){
+    switch (kind) {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP: return true;
+#endif
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD: return true;
+#endif
+        case COMPRESSION_NONE: return true;
+        default: return false;
+    }
+}
+
+decompressor::decompressor(){
+    fd = -1;
+    kind = COMPRESSION_NONE;
+    input = NULL;
+    input_used = START;
+    input_size = START;
+    input_end = false;
+    stream = NULL;
+    finished = false;
+    failed = false;
+    threaded = false;
+    for (unsigned i = 0; i < DECOMPRESS_SLOTS; i++) {
+        blocks[i] = NULL;
+        block_size[i] = START;
+    }
+    produced = START;
+    consumed = START;
+    offset = START;
+    stopping = false;
+    done = false;
+}
+
+decompressor::~decompressor(){
+    close();
+}
+
+bool decompressor::open(int file, compression_t compression, const char *prefix, size_t prefix_size, bool helper_thread){
+    close();
+    if (!compression_supported(compression) || compression == COMPRESSION_NONE) {
+        cerr << "support for " << compression_name(compression) << " compressed traces is not compiled in" << endl;
+        return false;
+    }
+    fd = file;
+    kind = compression;
+    input = new unsigned char[DECOMPRESS_INPUT > prefix_size ? DECOMPRESS_INPUT : prefix_size];
+    memcpy(input, prefix, prefix_size);
+    input_used = START;
+    input_size = prefix_size;
+    input_end = false;
+    finished = false;
+    failed = false;
+
+#ifdef HAVE_ZLIB
+    if (kind == COMPRESSION_GZIP) {
+        z_stream *z = new z_stream;
+        memset(z, 0, sizeof(z_stream));
+        // 15 window bits + 32: zlib or gzip header, detected automatically
+        if (inflateInit2(z, 15 + 32) != Z_OK) {
+            cerr << "cannot initialize the gzip decoder" << endl;
+            delete z;
+            close();
+            return false;
+        }
+        stream = z;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (kind == COMPRESSION_ZSTD) {
+        ZSTD_DStream *z = ZSTD_createDStream();
+        if (z == NULL || ZSTD_isError(ZSTD_initDStream(z))) {
+            cerr << "cannot initialize the zstd decoder" << endl;
+            if (z != NULL) ZSTD_freeDStream(z);
+            close();
+            return false;
+        }
+        stream = z;
+    }
+#endif
+
+    threaded = helper_thread;
+    if (threaded) {
+        for (unsigned i = 0; i < DECOMPRESS_SLOTS; i++) {
+            blocks[i] = new char[DECOMPRESS_BLOCK];
+            block_size[i] = START;
+        }
+        produced = START;
+        consumed = START;
+        offset = START;
+        stopping = false;
+        done = false;
+        helper = thread(&decompressor::produce, this);
+    }
+    return true;
+}
+
+void decompressor::close(){
+    if (helper.joinable()) {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        emptied.notify_all();
+        helper.join();
+    }
+    for (unsigned i = 0; i < DECOMPRESS_SLOTS; i++) {
+        delete[] blocks[i];
+        blocks[i] = NULL;
+    }
+    threaded = false;
+#ifdef HAVE_ZLIB
+    if (kind == COMPRESSION_GZIP && stream != NULL) {
+        inflateEnd((z_stream *)stream);
+        delete (z_stream *)stream;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (kind == COMPRESSION_ZSTD && stream != NULL) {
+        ZSTD_freeDStream((ZSTD_DStream *)stream);
+    }
+#endif
+    stream = NULL;
+    delete[] input;
+    input = NULL;
+    input_used = START;
+    input_size = START;
+    fd = -1;
+    kind = COMPRESSION_NONE;
+}
+
+ssize_t decompressor::inflate_some(char *out, size_t max){
+    size_t written = START;
+
+    while (written < max && !finished && !failed) {
+        if (input_used == input_size && !input_end) {
+            ssize_t n;
+            do {
+                n = ::read(fd, input, DECOMPRESS_INPUT);
+            } while (n < 0 && errno == EINTR);
+            if (n < 0) {
+                cerr << "error reading the compressed trace" << endl;
+                failed = true;
+                break;
+            }
+            input_used = START;
+            input_size = n;
+            input_end = (n == 0);
+        }
+
+#ifdef HAVE_ZLIB
+        if (kind == COMPRESSION_GZIP) {
+            z_stream *z = (z_stream *)stream;
+            if (input_end && input_used == input_size && z->total_in == 0) {
+                // the file ends between two members
+                finished = true;
+                break;
+            }
+            z->next_in = input + input_used;
+            z->avail_in = input_size - input_used;
+            z->next_out = (Bytef *)out + written;
+            z->avail_out = max - written;
+            int status = inflate(z, Z_NO_FLUSH);
+            input_used = input_size - z->avail_in;
+            written = max - z->avail_out;
+            if (status == Z_STREAM_END) {
+                // gzip files may hold several members back to back
+                if (input_used == input_size && input_end) finished = true;
+                else inflateReset(z);
+            }else if (status == Z_BUF_ERROR && input_end && input_used == input_size) {
+                cerr << "truncated gzip trace" << endl;
+                failed = true;
+            }else if (status != Z_OK && status != Z_BUF_ERROR) {
+                cerr << "corrupted gzip trace" << endl;
+                failed = true;
+            }
+            continue;
+        }
+#endif
+#ifdef HAVE_ZSTD
+        if (kind == COMPRESSION_ZSTD) {
+            ZSTD_inBuffer in = {input, input_size, input_used};
+            ZSTD_outBuffer result = {out, max, written};
+            size_t status = ZSTD_decompressStream((ZSTD_DStream *)stream, &in, &result);
+            input_used = in.pos;
+            written = result.pos;
+            if (ZSTD_isError(status)) {
+                cerr << "corrupted zstd trace: " << ZSTD_getErrorName(status) << endl;
+                failed = true;
+            }else if (input_end && input_used == input_size && result.pos < result.size) {
+                // status 0: every frame complete
+                if (status != 0) {
+                    cerr << "truncated zstd trace" << endl;
+                    failed = true;
+                }
+                finished = true;
+            }
+            continue;
+        }
+#endif
+        failed = true;
+    }
+
+    if (written == 0 && failed) return -1;
+    return written;
+}
+
+void decompressor::produce(){
+    for (;;) {
+        unique_lock<mutex> guard(lock);
+        emptied.wait(guard, [this](){ return stopping || produced - consumed < DECOMPRESS_SLOTS; });
+        if (stopping) return;
+        unsigned slot = produced % DECOMPRESS_SLOTS;
+        guard.unlock();
+
+        ssize_t n = inflate_some(blocks[slot], DECOMPRESS_BLOCK);
+
+        guard.lock();
+        if (n <= 0) {
+            done = true;
+            filled.notify_all();
+            return;
+        }
+        block_size[slot] = n;
+        produced++;
+        filled.notify_all();
+    }
+}
+
+ssize_t decompressor::read(char *out, size_t max){
+    if (stream == NULL) return -1;
+    if (!threaded) return inflate_some(out, max);
+
+    size_t written = START;
+    unique_lock<mutex> guard(lock);
+    while (written < max) {
+        filled.wait(guard, [this](){ return done || produced != consumed; });
+        if (produced == consumed) break;
+        unsigned slot = consumed % DECOMPRESS_SLOTS;
+        size_t n = block_size[slot] - offset;
+        if (n > max - written) n = max - written;
+        memcpy(out + written, blocks[slot] + offset, n);
+        written += n;
+        offset += n;
+        if (offset == block_size[slot]) {
+            offset = START;
+            consumed++;
+            emptied.notify_all();
+        }
+    }
+    if (written == 0 && failed) return -1;
+    return written;
+}
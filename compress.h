@@ -0,0 +1,94 @@
+#ifndef COMPRESS_H_
+#define COMPRESS_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/*
+* Streaming decompression of trace files. Support for each format is compiled in when its library is
+* found at build time (HAVE_ZLIB, HAVE_ZSTD, set by the Makefile); a trace in a format that was not
+* compiled in is reported and reads as empty.
+*/
+typedef enum {COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD} compression_t;
+
+#define COMPRESSION_MAGIC 4       //bytes needed to recognize a compressed file
+#define DECOMPRESS_INPUT (1 << 18)  //compressed bytes read from the file at a time
+#define DECOMPRESS_BLOCK (1 << 20)  //decompressed bytes per block handed to the reader
+#define DECOMPRESS_SLOTS 4          //blocks buffered by the helper thread
+
+// format of a file starting with "bytes" ("size" of them, at least COMPRESSION_MAGIC for a match)
+compression_t detect_compression(const unsigned char *bytes, size_t size);
+
+// name of the format, for messages
+const char *compression_name(compression_t kind);
+
+// true when support for "kind" was compiled in
+bool compression_supported(compression_t kind);
+
+/*
+* Decompressed view of a file descriptor, read like the file itself. Memory stays bounded: one input
+* buffer, the decoder state and, on a helper thread, DECOMPRESS_SLOTS output blocks.
+*/
+class decompressor{
+
+    int fd;
+    compression_t kind;
+
+    /* compressed input */
+    unsigned char *input;
+    size_t input_used;
+    size_t input_size;
+    bool input_end;
+
+    /* decoder state (z_stream or ZSTD_DStream) */
+    void *stream;
+    bool finished;
+    bool failed;
+
+    /* helper thread: ring of decompressed blocks */
+    bool threaded;
+    thread helper;
+    mutex lock;
+    condition_variable filled;
+    condition_variable emptied;
+    char *blocks[DECOMPRESS_SLOTS];
+    size_t block_size[DECOMPRESS_SLOTS];
+    unsigned long long produced;
+    unsigned long long consumed;
+    size_t offset;
+    bool stopping;
+    bool done;
+
+    // decompresses up to "max" bytes into "out"; returns 0 at the end of the data, -1 on errors
+    ssize_t inflate_some(char *out, size_t max);
+
+    // helper thread body: fills the ring until the data ends or the decompressor closes
+    void produce();
+
+    // decompressors own a thread and a decoder and are not copied
+    decompressor(const decompressor &);
+    decompressor &operator=(const decompressor &);
+
+public:
+
+    decompressor();
+
+    ~decompressor();
+
+    // decompresses "kind" data from "fd": first "prefix" ("prefix_size" bytes already read from it), then
+    // the rest of the file; "threaded" decompresses ahead on a helper thread
+    bool open(int fd, compression_t kind, const char *prefix, size_t prefix_size, bool threaded=true);
+
+    // reads up to "max" decompressed bytes; returns 0 at the end of the data, -1 on errors
+    ssize_t read(char *out, size_t max);
+
+    // stops the helper and releases the decoder (the file descriptor stays open)
+    void close();
+};
+
+#endif /*COMPRESS_H_*/
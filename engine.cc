@@ -0,0 +1,62 @@
+#include "engine.h"
+
+/* the four write-policy variants of one (associativity, line size) engine */
+#define POLICIES(KERNEL, ASSOC, LINE) \
+    { { &cache::KERNEL<ASSOC, LINE, WRITE_BACK, WRITE_ALLOCATE>,       \
+        &cache::KERNEL<ASSOC, LINE, WRITE_BACK, NO_WRITE_ALLOCATE> },  \
+      { &cache::KERNEL<ASSOC, LINE, WRITE_THROUGH, WRITE_ALLOCATE>,    \
+        &cache::KERNEL<ASSOC, LINE, WRITE_THROUGH, NO_WRITE_ALLOCATE> } }
+
+#define KERNELS(ASSOC, LINE) \
+    { ASSOC, LINE, POLICIES(run_kernel, ASSOC, LINE), POLICIES(run_shard, ASSOC, LINE), POLICIES(run_batch, ASSOC, LINE) }
+
+#define LINE_KERNELS(ASSOC) \
+    KERNELS(ASSOC, 32), KERNELS(ASSOC, 64), KERNELS(ASSOC, 128), KERNELS(ASSOC, 256)
+
+void cache::select_kernel(unsigned associativity,
+                          unsigned line_size,
+                          write_policy_t wr_hit_policy,
+                          write_policy_t wr_miss_policy,
+                          kernel_t &kernel,
+                          shard_kernel_t &shard_kernel,
+                          batch_kernel_t &batch_kernel
+){
+    typedef struct{
+        unsigned associativity;
+        unsigned line_size;
+        kernel_t run[2][2]; // [write-through][no-write-allocate]
+        shard_kernel_t shard[2][2];
+        batch_kernel_t batch[2][2];
+    } engine_t;
+
+    /* pre-instantiated common configurations; index 0 is the generic engine */
+    /* fully-associative caches always take one of the FULLY_ASSOC engines (LINE 0: any line size) */
+    static const engine_t engines[] = {
+        KERNELS(0, 0),
+        KERNELS(FULLY_ASSOC, 0),
+        LINE_KERNELS(FULLY_ASSOC),
+        LINE_KERNELS(1),
+        LINE_KERNELS(2),
+        LINE_KERNELS(4),
+        LINE_KERNELS(8),
+        LINE_KERNELS(16),
+        LINE_KERNELS(32)
+    };
+
+    unsigned through = (wr_hit_policy == WRITE_THROUGH);
+    unsigned no_allocate = (wr_miss_policy == NO_WRITE_ALLOCATE);
+
+    const engine_t *engine = &engines[0];
+    for (unsigned i = 1; i < sizeof(engines) / sizeof(engines[0]); i++) {
+        if (engines[i].associativity == associativity && engines[i].line_size == line_size) {
+            engine = &engines[i];
+            break;
+        }
+        if (engines[i].associativity == associativity && engines[i].line_size == 0) {
+            engine = &engines[i];
+        }
+    }
+    kernel = engine->run[through][no_allocate];
+    shard_kernel = engine->shard[through][no_allocate];
+    batch_kernel = engine->batch[through][no_allocate];
+}
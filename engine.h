@@ -0,0 +1,282 @@
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include "cache.h"
+#include <string.h>
+
+/*
+* Access engine of the cache simulator.
+* Every function is a template over the associativity (ASSOC) and, for the access loop, the line size
+* (LINE) and write policies (HIT, MISS). A zero ASSOC/LINE reads the value from the cache object, so
+* the generic path and the specialized ones share the same code; with constants the compiler unrolls
+* the way scans, folds the block layout and shifts, and drops the policy branches.
+* Specialized engines only run the direct set mapping; the generic one indexes through set_of.
+*/
+
+constexpr unsigned line_shift(unsigned line_size){
+    return (line_size <= 1) ? 0 : 1 + line_shift(line_size >> 1);
+}
+
+// returns the valid way of "set" holding "tag", or -1
+template <unsigned ASSOC>
+inline int cache::lookup(unsigned long long set, long long tag){
+    long long *way_tag = set_tags<ASSOC>(set);
+    unsigned char *state = set_state<ASSOC>(set);
+
+    if (is_fully<ASSOC>()) {
+        return fully->find(tag);
+    }
+    if (ASSOC != 0 && ASSOC <= 8) {
+        for (unsigned i = 0; i < ASSOC; i++) {
+            if ((state[i] & BLOCK_VALID) && (way_tag[i] == tag)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    return match(way_tag, state, ways<ASSOC>(), tag);
+}
+
+// returns the first invalid way of "set", or -1 when the set is full
+// (fully-associative caches hand out, and so reserve, an invalid way from their free stack)
+template <unsigned ASSOC>
+inline int cache::first_invalid(unsigned long long set){
+    unsigned char *state = set_state<ASSOC>(set);
+
+    if (is_fully<ASSOC>()) {
+        uint32_t way = fully->claim();
+        return (way == NO_WAY) ? -1 : (int)way;
+    }
+
+    if (ASSOC != 0 && ASSOC <= 8) {
+        for (unsigned i = 0; i < ASSOC; i++) {
+            if (!(state[i] & BLOCK_VALID)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // eight state bytes per step: a full set costs ways/8 word tests
+    for (unsigned i = 0; i < ways<ASSOC>(); i += 8) {
+        unsigned long long word = 0;
+        unsigned n = (ways<ASSOC>() - i < 8) ? ways<ASSOC>() - i : 8;
+        memcpy(&word, state + i, n);
+        unsigned long long empty = ~word & (n == 8 ? 0x0101010101010101ULL : (0x0101010101010101ULL >> ((8 - n) * 8)));
+        if (empty) {
+            return i + (__builtin_ctzll(empty) >> 3);
+        }
+    }
+    return -1;
+}
+
+// returns the way of the full "set" chosen by the replacement policy
+template <unsigned ASSOC>
+inline unsigned cache::victim(unsigned long long set){
+    if (is_fully<ASSOC>()) return fully->lru();
+    if (ways<ASSOC>() == 1) return 0;
+    return replacement_victim(replacement, set_meta<ASSOC>(set), ways<ASSOC>());
+}
+
+// places "tag" in an invalid way of "set", or in the victim way (writing it back when dirty)
+template <unsigned ASSOC>
+inline unsigned cache::fill(unsigned long long set, long long tag, counters_t &count){
+    long long *way_tag = set_tags<ASSOC>(set);
+    unsigned char *state = set_state<ASSOC>(set);
+    int empty = first_invalid<ASSOC>(set);
+
+    if (empty >= 0) {
+        way_tag[empty] = tag;
+        state[empty] = BLOCK_VALID;
+        replace_insert<ASSOC>(set, empty);
+        return empty;
+    }
+
+    PROFILE_START(start);
+    unsigned evicter = victim<ASSOC>(set);
+    PROFILE_STOP(count, PROFILE_EVICT, start);
+    count.eviction++;
+    if (state[evicter] & BLOCK_DIRTY) {
+        state[evicter] &= ~BLOCK_DIRTY;
+        count.memory++;
+    }
+    replace_remove<ASSOC>(evicter, false);
+    way_tag[evicter] = tag;
+    replace_insert<ASSOC>(set, evicter);
+    return evicter;
+}
+
+// processes one trace entry (a single access or a run record), including allocation, dirty tracking and the statistics
+template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS>
+inline void cache::step(const trace_entry_t &entry, counters_t &count){
+    const unsigned shift = LINE ? line_shift(LINE) : offset;
+    unsigned long long set = (ASSOC == 0) ? set_of(entry.address) : (entry.address >> shift) & index_shift;
+    int way = step_at<ASSOC, HIT, MISS>(set, entry.address >> (shift + indexes), entry.op, count);
+    if (entry.reads | entry.writes) {
+        fold<ASSOC, HIT>(set, way, entry.reads, entry.writes, count);
+    }
+}
+
+// processes one access once its set and tag are known; returns the way now holding the line, or -1
+// (write miss without allocation)
+template <unsigned ASSOC, write_policy_t HIT, write_policy_t MISS>
+inline int cache::step_at(unsigned long long set, long long tag, trace_op_t op, counters_t &count){
+    PROFILE_START(start);
+    int way = lookup<ASSOC>(set, tag);
+    PROFILE_STOP(count, PROFILE_LOOKUP, start);
+    PROFILE_SCAN(count, is_fully<ASSOC>() ? 1 : (way < 0) ? ways<ASSOC>() : way + 1);
+
+    if (op == TRACE_WRITE) {
+        count.writes++;
+        if (way < 0) {
+            count.wr_miss++;
+            if (MISS == WRITE_ALLOCATE) {
+                PROFILE_START(filled);
+                way = fill<ASSOC>(set, tag, count);
+                PROFILE_STOP(count, PROFILE_ALLOCATE, filled);
+                if (HIT == WRITE_THROUGH) {
+                    count.memory++;
+                }else{
+                    set_state<ASSOC>(set)[way] |= BLOCK_DIRTY;
+                }
+            }else{
+                count.memory++;
+            }
+        }else{
+            count.hits++;
+            replace_hit<ASSOC>(set, way);
+            if (HIT == WRITE_BACK) {
+                set_state<ASSOC>(set)[way] |= BLOCK_DIRTY;
+            }else{
+                count.memory++;
+            }
+        }
+    }else{
+        count.reads++;
+        if (way < 0) {
+            count.rd_miss++;
+            PROFILE_START(filled);
+            way = fill<ASSOC>(set, tag, count);
+            PROFILE_STOP(count, PROFILE_ALLOCATE, filled);
+        }else{
+            count.hits++;
+            replace_hit<ASSOC>(set, way);
+        }
+    }
+    return way;
+}
+
+/*
+* accounts for the "reads" and "writes" folded into a run record (runs.h) once its leading access left
+* the line in "way": they all hit, or all miss without allocating when way is -1 (write-led records
+* fold writes only); every policy updates its state identically on repeated hits, so one update stands
+* for all of them
+*/
+template <unsigned ASSOC, write_policy_t HIT>
+inline void cache::fold(unsigned long long set, int way, unsigned reads, unsigned writes, counters_t &count){
+    count.reads += reads;
+    count.writes += writes;
+    if (way < 0) {
+        count.wr_miss += writes;
+        count.memory += writes;
+        return;
+    }
+    count.hits += reads + writes;
+    if (writes) {
+        if (HIT == WRITE_BACK) {
+            set_state<ASSOC>(set)[way] |= BLOCK_DIRTY;
+        }else{
+            count.memory += writes;
+        }
+    }
+    replace_hit<ASSOC>(set, way);
+}
+
+// processes "num_entries" accesses from the trace (all of them when 0); run records count as all their accesses
+template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS>
+void cache::run_kernel(unsigned num_entries){
+    unsigned long long first_access = number_memory_accesses;
+    trace_entry_t entry;
+
+    for (;;) {
+        PROFILE_START(start);
+        bool more = (num_entries != 0) ? trace.next(entry, num_entries - (number_memory_accesses - first_access)) : trace.next(entry);
+        PROFILE_STOP(counters, PROFILE_PARSE, start);
+        if (!more) break;
+
+        step<ASSOC, LINE, HIT, MISS>(entry, counters);
+        number_memory_accesses += trace_accesses(entry);
+
+        if ((num_entries != 0) && (number_memory_accesses - first_access) == num_entries) break;
+    }
+}
+
+// processes the accesses of one shard in trace order
+template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS>
+void cache::run_shard(const trace_entry_t *chunk, const unsigned *list, size_t count, counters_t &shard){
+    for (size_t i = 0; i < count; i++) {
+        const trace_entry_t &entry = chunk[list[i]];
+        step<ASSOC, LINE, HIT, MISS>(entry, shard);
+    }
+}
+
+/*
+* processes "count" accesses held by the caller: "entries" (run records included), or "addresses" all with operation "op"
+* blocks of BATCH_BLOCK accesses are split into set/tag/op arrays first (a branch-free loop the compiler
+* vectorizes), then simulated with the sets of the next accesses already being prefetched
+*/
+#define BATCH_BLOCK 256
+#define BATCH_PREFETCH 8
+
+template <unsigned ASSOC, unsigned LINE, write_policy_t HIT, write_policy_t MISS>
+void cache::run_batch(const trace_entry_t *entries, const address_t *addresses, trace_op_t op, size_t count){
+    const unsigned shift = LINE ? line_shift(LINE) : offset;
+    const unsigned long long mask = index_shift;
+    const unsigned tag_shift = shift + indexes;
+    unsigned long long block_set[BATCH_BLOCK];
+    long long block_tag[BATCH_BLOCK];
+    trace_op_t block_op[BATCH_BLOCK];
+    unsigned long long folded = 0;
+
+    for (size_t first = 0; first < count; first += BATCH_BLOCK) {
+        size_t n = (count - first < BATCH_BLOCK) ? count - first : BATCH_BLOCK;
+
+        if (ASSOC == 0 && !indexing.direct) {
+            for (size_t i = 0; i < n; i++) {
+                address_t address = (entries != NULL) ? entries[first + i].address : addresses[first + i];
+                block_set[i] = set_of(address);
+                block_tag[i] = address >> tag_shift;
+                block_op[i] = (entries != NULL) ? entries[first + i].op : op;
+            }
+        }else if (entries != NULL) {
+            const trace_entry_t *block = entries + first;
+            for (size_t i = 0; i < n; i++) {
+                block_set[i] = (block[i].address >> shift) & mask;
+                block_tag[i] = block[i].address >> tag_shift;
+                block_op[i] = block[i].op;
+            }
+        }else{
+            const address_t *block = addresses + first;
+            for (size_t i = 0; i < n; i++) {
+                block_set[i] = (block[i] >> shift) & mask;
+                block_tag[i] = block[i] >> tag_shift;
+                block_op[i] = op;
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if (i + BATCH_PREFETCH < n) {
+                __builtin_prefetch(set_block<ASSOC>(block_set[i + BATCH_PREFETCH]));
+            }
+            int way = step_at<ASSOC, HIT, MISS>(block_set[i], block_tag[i], block_op[i], counters);
+            if (entries != NULL && (entries[first + i].reads | entries[first + i].writes)) {
+                const trace_entry_t &record = entries[first + i];
+                fold<ASSOC, HIT>(block_set[i], way, record.reads, record.writes, counters);
+                folded += record.reads + record.writes;
+            }
+        }
+    }
+    number_memory_accesses += count + folded;
+}
+
+#endif /*ENGINE_H_*/
@@ -0,0 +1,242 @@
+#include "cache.h"
+#include "export.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define START 0x0
+#define EXPORT_LINE 128 //room reserved per text record (the longest is a JSON line of four 64-bit numbers)
+
+export_buffer::export_buffer(){
+    fd = -1;
+    data = NULL;
+    used = START;
+    failed = false;
+}
+
+export_buffer::~export_buffer(){
+    close();
+}
+
+bool export_buffer::open(const char *filename){
+    close();
+    data = (char *)malloc(EXPORT_CHUNK);
+    if (data == NULL) return false;
+    fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(data);
+        data = NULL;
+        return false;
+    }
+    used = START;
+    failed = false;
+    return true;
+}
+
+// writes all of "bytes"
+static bool write_all(int fd, const char *p, size_t bytes){
+    while (bytes > 0) {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n <= 0) return false;
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+bool export_buffer::close(){
+    if (fd < 0) return false;
+    if (!write_all(fd, data, used)) failed = true;
+    if (::close(fd) != 0) failed = true;
+    fd = -1;
+    free(data);
+    data = NULL;
+    used = START;
+    return !failed;
+}
+
+void export_buffer::reserve(size_t bytes){
+    if (used + bytes <= EXPORT_CHUNK) return;
+    if (!write_all(fd, data, used)) failed = true;
+    used = START;
+}
+
+void export_buffer::put(const void *bytes, size_t count){
+    const char *p = (const char *)bytes;
+    while (count > 0) {
+        size_t n = (count < EXPORT_CHUNK) ? count : EXPORT_CHUNK;
+        reserve(n);
+        memcpy(data + used, p, n);
+        used += n;
+        p += n;
+        count -= n;
+    }
+}
+
+void export_buffer::text(const char *s){
+    size_t n = strlen(s);
+    memcpy(data + used, s, n);
+    used += n;
+}
+
+void export_buffer::decimal(unsigned long long value){
+    char digits[20];
+    unsigned n = START;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (n) {
+        data[used++] = digits[--n];
+    }
+}
+
+void export_buffer::hexadecimal(unsigned long long value){
+    static const char hex_digits[] = "0123456789abcdef";
+    unsigned n = 4;
+    while (n < 64 && (value >> n)) {
+        n += 4;
+    }
+    data[used++] = '0';
+    data[used++] = 'x';
+    while (n) {
+        n -= 4;
+        data[used++] = hex_digits[(value >> n) & 0xF];
+    }
+}
+
+void export_buffer::real(double value){
+    used += snprintf(data + used, EXPORT_CHUNK - used, "%g", value);
+}
+
+bool export_buffer::patch(const void *bytes, size_t count, size_t offset){
+    reserve(EXPORT_CHUNK);
+    return pwrite(fd, bytes, count, offset) == (ssize_t)count;
+}
+
+/*
+* The tag array is walked in memory order (set by set) and only through its populated pages; every
+* record is formatted in place, so the dump costs about as much as reading the array.
+*/
+bool cache::export_tag_array(const char *filename, export_format_t format){
+    export_buffer out;
+    export_header_t header;
+
+    if (!out.open(filename)) {
+        cerr << "cannot create export file " << filename << endl;
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EXPORT_TAGS_MAGIC, 4);
+    header.version = EXPORT_VERSION;
+    header.ways = coeval;
+    header.record = sizeof(export_block_t);
+    header.sets = sized;
+    if (format == EXPORT_BINARY) {
+        out.put(&header, sizeof(header));
+    }else if (format == EXPORT_CSV) {
+        out.reserve(EXPORT_LINE);
+        out.text("set,way,dirty,tag,address\n");
+    }
+
+    for (unsigned long long j = START; j < sized; j++) {
+        if (pages[j >> page_shift] == NULL) {
+            j |= page_mask;
+            continue;
+        }
+        const long long *way_tag = set_tags(j);
+        const unsigned char *state = set_state(j);
+        for (unsigned i = START; i < coeval; i++) {
+            if (!(state[i] & BLOCK_VALID)) continue;
+            header.records++;
+
+            address_t address = block_address(j, way_tag[i]);
+            if (format == EXPORT_BINARY) {
+                export_block_t block = {j, way_tag[i], (uint64_t)address, i, state[i]};
+                out.put(&block, sizeof(block));
+                continue;
+            }
+
+            out.reserve(EXPORT_LINE);
+            if (format == EXPORT_JSONL) out.text("{\"set\":");
+            out.decimal(j);
+            out.text((format == EXPORT_JSONL) ? ",\"way\":" : ",");
+            out.decimal(i);
+            out.text((format == EXPORT_JSONL) ? ",\"dirty\":" : ",");
+            out.character((state[i] & BLOCK_DIRTY) ? '1' : '0');
+            out.text((format == EXPORT_JSONL) ? ",\"tag\":\"" : ",");
+            out.hexadecimal(way_tag[i]);
+            out.text((format == EXPORT_JSONL) ? "\",\"address\":\"" : ",");
+            out.hexadecimal(address);
+            out.text((format == EXPORT_JSONL) ? "\"}\n" : "\n");
+        }
+    }
+
+    bool ok = (format != EXPORT_BINARY) || out.patch(&header, sizeof(header), 0);
+    ok = out.close() && ok;
+    if (!ok) cerr << "cannot write export file " << filename << endl;
+    return ok;
+}
+
+bool cache::export_statistics(const char *filename, export_format_t format){
+    export_buffer out;
+    cache_stats_t stats = get_statistics();
+
+    if (!out.open(filename)) {
+        cerr << "cannot create export file " << filename << endl;
+        return false;
+    }
+
+    if (format == EXPORT_BINARY) {
+        export_header_t header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, EXPORT_STATS_MAGIC, 4);
+        header.version = EXPORT_VERSION;
+        header.ways = coeval;
+        export_stats_t record;
+        memset(&record, 0, sizeof(record));
+        record.accesses = stats.accesses;
+        record.reads = stats.reads;
+        record.rd_miss = stats.rd_miss;
+        record.writes = stats.writes;
+        record.wr_miss = stats.wr_miss;
+        record.eviction = stats.eviction;
+        record.memory = stats.memory;
+        record.amat = stats.amat;
+
+        header.record = sizeof(record);
+        header.sets = sized;
+        header.records = 1;
+        out.put(&header, sizeof(header));
+        out.put(&record, sizeof(record));
+    }else{
+        static const char *keys[] = {"accesses", "reads", "read_misses", "writes", "write_misses", "evictions", "memory_writes"};
+        const unsigned long long values[] = {stats.accesses, stats.reads, stats.rd_miss, stats.writes, stats.wr_miss, stats.eviction, stats.memory};
+        bool csv = (format == EXPORT_CSV);
+
+        out.reserve(2 * EXPORT_LINE);
+        if (csv) out.text("accesses,reads,read_misses,writes,write_misses,evictions,memory_writes,amat\n");
+        else out.character('{');
+        for (unsigned k = START; k < sizeof(values) / sizeof(values[0]); k++) {
+            if (!csv) {
+                out.character('"');
+                out.text(keys[k]);
+                out.text("\":");
+            }
+            out.decimal(values[k]);
+            out.character(',');
+        }
+        if (!csv) out.text("\"amat\":");
+        if (stats.amat == stats.amat) out.real(stats.amat);
+        else out.text(csv ? "nan" : "null"); // no accesses yet
+        out.text(csv ? "\n" : "}\n");
+    }
+
+    bool ok = out.close();
+    if (!ok) cerr << "cannot write export file " << filename << endl;
+    return ok;
+}
@@ -0,0 +1,104 @@
+#ifndef EXPORT_H_
+#define EXPORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+using namespace std;
+
+typedef enum {EXPORT_CSV, EXPORT_JSONL, EXPORT_BINARY} export_format_t;
+
+/*
+* Structured dumps of the tag array and of the statistics (cache::export_tag_array, cache::export_statistics).
+* Tag array, one record per valid way, in set order then way order:
+*   EXPORT_CSV:    header "set,way,dirty,tag,address", then e.g. "577537,0,1,0xa,0x52340040"
+*   EXPORT_JSONL:  {"set":577537,"way":0,"dirty":1,"tag":"0xa","address":"0x52340040"}
+*   EXPORT_BINARY: an export_header_t (EXPORT_TAGS_MAGIC), then export_block_t records
+* Statistics, one record:
+*   EXPORT_CSV:    header "accesses,reads,read_misses,writes,write_misses,evictions,memory_writes,amat", one line
+*   EXPORT_JSONL:  one object with the same keys
+*   EXPORT_BINARY: an export_header_t (EXPORT_STATS_MAGIC), then an export_stats_t
+* Binary dumps are in host byte order.
+*/
+#define EXPORT_TAGS_MAGIC "CTAG"
+#define EXPORT_STATS_MAGIC "CSTS"
+#define EXPORT_VERSION 1
+#define EXPORT_CHUNK (1 << 20) //bytes gathered before each write
+
+typedef struct{
+    char magic[4];
+    uint32_t version;
+    uint32_t ways;
+    uint32_t record;             // bytes per record
+    uint64_t sets;
+    uint64_t records;
+} export_header_t;
+
+typedef struct{
+    uint64_t set;
+    int64_t tag;
+    uint64_t address;
+    uint32_t way;
+    uint32_t state;              // BLOCK_VALID | BLOCK_DIRTY bits (cache.h)
+} export_block_t;
+
+/* cache_stats_t (cache.h) with a fixed layout and no padding left undefined */
+typedef struct{
+    uint64_t accesses;
+    uint64_t reads;
+    uint64_t rd_miss;
+    uint64_t writes;
+    uint64_t wr_miss;
+    uint64_t eviction;
+    uint64_t memory;
+    float amat;
+    uint32_t reserved;           // 0
+} export_stats_t;
+
+/*
+* Output file written in EXPORT_CHUNK pieces: records are formatted straight into the buffer (no stream
+* manipulators, no per-line flush) and the buffer goes out with one write whenever it fills up.
+*/
+class export_buffer{
+
+    int fd;
+    char *data;
+    size_t used;
+    bool failed;
+
+    // export buffers own their file and are not copied
+    export_buffer(const export_buffer &);
+    export_buffer &operator=(const export_buffer &);
+
+public:
+
+    export_buffer();
+
+    ~export_buffer();
+
+    // creates "filename"
+    bool open(const char *filename);
+
+    // writes what is buffered and closes the file; false when any write failed
+    bool close();
+
+    // makes room for "bytes" more bytes (at most EXPORT_CHUNK), writing the buffer out when needed
+    void reserve(size_t bytes);
+
+    // appends "bytes" raw bytes
+    void put(const void *bytes, size_t count);
+
+    // appends text (reserve first: the formatting calls do not check for room)
+    void text(const char *s);
+    void decimal(unsigned long long value);
+    void hexadecimal(unsigned long long value);
+    void real(double value);
+    void character(char c){
+        data[used++] = c;
+    }
+
+    // rewrites "count" bytes at file offset "offset" once everything before is out (binary headers)
+    bool patch(const void *bytes, size_t count, size_t offset);
+};
+
+#endif /*EXPORT_H_*/
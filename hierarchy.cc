@@ -0,0 +1,262 @@
+#include "hierarchy.h"
+#include <iostream>
+#include <stdlib.h>
+
+using namespace std;
+
+#define START 0x0
+
+hierarchy::hierarchy(inclusion_policy_t inclusion_policy){
+    inclusion = inclusion_policy;
+    number_memory_accesses = START;
+    memory_reads = START;
+    memory_writes = START;
+}
+
+hierarchy::~hierarchy(){
+    for (unsigned i = START; i < levels.size(); i++) {
+        delete levels[i];
+    }
+    levels.clear();
+}
+
+void hierarchy::add_level(cache *level){
+    level_stats_t empty = {};
+    if (inclusion == EXCLUSIVE && !levels.empty() && levels.back()->lsize != level->lsize) {
+        cerr << "exclusive hierarchies require the same line size at every level" << endl;
+        exit(EXIT_FAILURE);
+    }
+    levels.push_back(level);
+    stats.push_back(empty);
+}
+
+void hierarchy::load_trace(const char *filename, trace_mode_t mode){
+    if (!trace.open(filename, mode)){
+        cerr << "cannot open trace file " << filename << endl;
+    }
+}
+
+void hierarchy::load_trace(trace_source *source){
+    if (!trace.open(source)){
+        cerr << "cannot allocate the workload buffer" << endl;
+    }
+}
+
+void hierarchy::run(unsigned num_entries){
+    unsigned long long first_access = number_memory_accesses;
+    trace_entry_t entry;
+
+    // run records (runs.h) are cut into single accesses, replayed at the address of the record
+    while (trace.next(entry, 1)) {
+        access(entry.address, entry.op);
+
+        if ((num_entries != 0) && (number_memory_accesses - first_access) == num_entries) break;
+    }
+}
+
+void hierarchy::access(address_t address, trace_op_t op){
+    number_memory_accesses++;
+    if (levels.empty()) return;
+
+    if (inclusion != EXCLUSIVE || levels.size() == 1) {
+        request(0, address, op, true);
+        return;
+    }
+
+    cache *top = levels[0];
+    level_stats_t &s = stats[0];
+    bool write = (op == TRACE_WRITE);
+
+    write ? s.writes++ : s.reads++;
+    int way = top->probe(address);
+    if (way >= 0) {
+        bool through = write && top->hit == WRITE_THROUGH;
+        top->touch(address, way, write && !through);
+        // exclusive lower levels never hold a line of the first level
+        if (through) memory_writes++;
+        return;
+    }
+    write ? s.wr_miss++ : s.rd_miss++;
+    exclusive_miss(address, op);
+}
+
+void hierarchy::request(unsigned i, address_t address, trace_op_t op, bool demand){
+    if (i == levels.size()) {
+        (op == TRACE_WRITE) ? memory_writes++ : memory_reads++;
+        return;
+    }
+
+    cache *level = levels[i];
+    level_stats_t &s = stats[i];
+    bool write = (op == TRACE_WRITE);
+    bool through = write && level->hit == WRITE_THROUGH;
+
+    if (demand) {
+        write ? s.writes++ : s.reads++;
+    }else{
+        s.writebacks++;
+    }
+
+    int way = level->probe(address);
+    if (way >= 0) {
+        level->touch(address, way, write && !through);
+        if (through) request(i + 1, address, TRACE_WRITE, false);
+        return;
+    }
+
+    if (demand) {
+        write ? s.wr_miss++ : s.rd_miss++;
+    }else{
+        s.wb_miss++;
+    }
+    if (write && level->miss == NO_WRITE_ALLOCATE) {
+        request(i + 1, address, TRACE_WRITE, demand);
+        return;
+    }
+
+    // demand misses fetch the line before allocating it (so an inclusive level below already holds it);
+    // write-backs carry the whole line and allocate without a fetch
+    if (demand) {
+        request(i + 1, address, TRACE_READ, true);
+    }
+
+    address_t victim;
+    bool victim_dirty;
+    if (level->install(address, write && !through, victim, victim_dirty)) {
+        s.eviction++;
+        evicted(i, victim, victim_dirty);
+    }
+    if (through) request(i + 1, address, TRACE_WRITE, false);
+}
+
+void hierarchy::evicted(unsigned i, address_t victim, bool dirty){
+    if (inclusion == INCLUSIVE) {
+        unsigned line = levels[i]->lsize;
+        for (unsigned j = START; j < i; j++) {
+            unsigned step = (levels[j]->lsize < line) ? levels[j]->lsize : line;
+            for (unsigned long long offset = START; offset < line; offset += step) {
+                bool upper_dirty;
+                if (levels[j]->invalidate(victim + offset, upper_dirty)) {
+                    stats[j].back_invalidations++;
+                    dirty = dirty || upper_dirty;
+                }
+            }
+        }
+    }
+    if (dirty) request(i + 1, victim, TRACE_WRITE, false);
+}
+
+void hierarchy::exclusive_miss(address_t address, trace_op_t op){
+    cache *top = levels[0];
+    bool write = (op == TRACE_WRITE);
+    bool allocate = !write || top->miss == WRITE_ALLOCATE;
+    bool dirty = false;
+    unsigned i = 1;
+
+    // the first lower level holding the line gives it up (or takes the write when the first level does not allocate)
+    for (; i < levels.size(); i++) {
+        level_stats_t &s = stats[i];
+        write ? s.writes++ : s.reads++;
+
+        if (!allocate) {
+            int way = levels[i]->probe(address);
+            if (way >= 0) {
+                bool through = levels[i]->hit == WRITE_THROUGH;
+                levels[i]->touch(address, way, !through);
+                if (through) memory_writes++;
+                return;
+            }
+        }else if (levels[i]->invalidate(address, dirty)) {
+            break;
+        }
+        write ? s.wr_miss++ : s.rd_miss++;
+    }
+    if (!allocate) {
+        memory_writes++;
+        return;
+    }
+    if (i == levels.size()) {
+        memory_reads++;
+    }
+
+    dirty = dirty || (write && top->hit == WRITE_BACK);
+    if (top->hit == WRITE_THROUGH && (dirty || write)) {
+        memory_writes++;
+        dirty = false;
+    }
+
+    // the victim of each level moves one level down
+    address_t victim;
+    bool victim_dirty;
+    if (!top->install(address, dirty, victim, victim_dirty)) return;
+    stats[0].eviction++;
+
+    for (i = 1; i < levels.size(); i++) {
+        cache *level = levels[i];
+        address_t next;
+        bool next_dirty;
+
+        if (victim_dirty) stats[i].writebacks++;
+        if (victim_dirty && level->hit == WRITE_THROUGH) {
+            memory_writes++;
+            victim_dirty = false;
+        }
+        if (!level->install(victim, victim_dirty, next, next_dirty)) return;
+        stats[i].eviction++;
+        victim = next;
+        victim_dirty = next_dirty;
+    }
+    if (victim_dirty) memory_writes++;
+}
+
+void hierarchy::print_configuration(){
+    const char *names[] = {"inclusive", "exclusive", "non-inclusive"};
+
+    cout << "HIERARCHY CONFIGURATION" << endl;
+    cout << "levels = " << levels.size() << endl;
+    cout << "inclusion policy = " << names[inclusion] << endl;
+    for (unsigned i = START; i < levels.size(); i++) {
+        cout << endl << "LEVEL " << (i + 1) << endl;
+        levels[i]->print_configuration();
+    }
+}
+
+level_stats_t hierarchy::get_level_statistics(unsigned i){
+    return stats[i];
+}
+
+float hierarchy::amat(){
+    if (levels.empty()) return 0;
+
+    float time = levels.back()->penalty;
+    for (unsigned i = levels.size(); i-- > 0;) {
+        level_stats_t &s = stats[i];
+        unsigned long long demand = s.reads + s.writes;
+        float miss_rate = demand ? float(s.rd_miss + s.wr_miss) / demand : 0;
+        time = levels[i]->hitT + miss_rate * time;
+    }
+    return time;
+}
+
+void hierarchy::print_statistics(){
+    cout << "STATISTICS" << endl;
+    cout << "memory accesses = " << dec << number_memory_accesses << endl;
+    for (unsigned i = START; i < levels.size(); i++) {
+        level_stats_t &s = stats[i];
+        unsigned long long demand = s.reads + s.writes;
+
+        cout << "LEVEL " << (i + 1) << endl;
+        cout << "read = " << s.reads << endl;
+        cout << "read misses = " << s.rd_miss << endl;
+        cout << "write = " << s.writes << endl;
+        cout << "write misses = " << s.wr_miss << endl;
+        cout << "write-backs received = " << s.writebacks << endl;
+        cout << "write-back misses = " << s.wb_miss << endl;
+        cout << "evictions = " << s.eviction << endl;
+        cout << "back-invalidations = " << s.back_invalidations << endl;
+        cout << "local miss rate = " << (demand ? float(s.rd_miss + s.wr_miss) / demand : 0) << endl;
+    }
+    cout << "memory reads = " << memory_reads << endl;
+    cout << "memory writes = " << memory_writes << endl;
+    cout << "average memory access time = " << amat() << endl;
+}
@@ -0,0 +1,95 @@
+#ifndef HIERARCHY_H_
+#define HIERARCHY_H_
+
+#include <vector>
+#include "cache.h"
+
+using namespace std;
+
+typedef enum {INCLUSIVE, EXCLUSIVE, NON_INCLUSIVE} inclusion_policy_t;
+
+/* per-level statistics of a hierarchy */
+typedef struct{
+    unsigned long long reads;          // demand reads (and, below the first level, line fetches)
+    unsigned long long rd_miss;
+    unsigned long long writes;         // demand writes
+    unsigned long long wr_miss;
+    unsigned long long writebacks;     // dirty lines / write-through writes received from the level above
+    unsigned long long wb_miss;
+    unsigned long long eviction;
+    unsigned long long back_invalidations;
+} level_stats_t;
+
+/*
+* Multi-level cache hierarchy: the first cache added is the one closest to the processor.
+* Misses fetch the line from the next level and dirty victims (or write-through writes) are written to
+* it; the last level talks to memory, whose latency is the miss penalty of the last level.
+*   INCLUSIVE:     every level fills on a miss; lines evicted from a lower level are invalidated above
+*   NON_INCLUSIVE: every level fills on a miss; no back-invalidation
+*   EXCLUSIVE:     only the first level fills on a miss; lower levels hold the victims of the level above
+*                  and give a line up when it moves to the first level (all levels must use the same line size)
+* The levels are plain cache objects driven through direct calls to their tag array operations.
+*/
+class hierarchy{
+
+    /* number of memory accesses processed */
+    unsigned long long number_memory_accesses;
+
+    /* trace file reader */
+    trace_reader trace;
+
+    inclusion_policy_t inclusion;
+
+    /* levels (owned) and their statistics */
+    vector<cache *> levels;
+    vector<level_stats_t> stats;
+
+    unsigned long long memory_reads;
+    unsigned long long memory_writes;
+
+    // a request for "address" reaches level "i" (levels.size() is memory); "demand" requests come from
+    // a processor access, the others are write-backs
+    void request(unsigned i, address_t address, trace_op_t op, bool demand);
+
+    // exclusive hierarchy: handles a first-level miss and the victim chain
+    void exclusive_miss(address_t address, trace_op_t op);
+
+    // writes "victim" (evicted from level "i", dirty or not) where the inclusion policy puts it
+    void evicted(unsigned i, address_t victim, bool dirty);
+
+public:
+
+    hierarchy(inclusion_policy_t inclusion_policy);
+
+    ~hierarchy();
+
+    // appends a level below the existing ones; the hierarchy takes ownership of "level"
+    // (exclusive hierarchies exit on a line size different from the level above)
+    void add_level(cache *level);
+
+    // loads the trace file (with name "filename") so that it can be used by the "run" function
+    void load_trace(const char *filename, trace_mode_t mode=TRACE_MMAP);
+
+    // reads the accesses generated by "source" (e.g. a workload), which must outlive the run
+    void load_trace(trace_source *source);
+
+    // processes "num_memory_accesses" memory accesses from the input trace (all of them when 0)
+    void run(unsigned num_memory_accesses=0);
+
+    // processes one processor access
+    void access(address_t address, trace_op_t op);
+
+    // prints the configuration of every level
+    void print_configuration();
+
+    // prints the per-level statistics and the average memory access time
+    void print_statistics();
+
+    // statistics of level "i"
+    level_stats_t get_level_statistics(unsigned i);
+
+    // average memory access time: hit time of each level plus its local demand miss rate times the time below
+    float amat();
+};
+
+#endif /*HIERARCHY_H_*/
@@ -0,0 +1,124 @@
+#include "interval.h"
+#include <string.h>
+#include <chrono>
+
+#define START 0x0
+#define OUTPUT_BUFFER (1 << 20) //stdio buffer of the interval file
+#define WRITER_PERIOD 100       //ms between two checks of the writer when nobody wakes it up
+
+interval_log::interval_log(){
+    head = START;
+    tail = START;
+    closing = false;
+    out = NULL;
+    format = INTERVAL_CSV;
+    memset(&previous, 0, sizeof(previous));
+    written = START;
+    length = START;
+    last = START;
+}
+
+interval_log::~interval_log(){
+    close();
+}
+
+bool interval_log::open(const char *filename, unsigned long long interval, const interval_t &origin, interval_format_t file_format){
+    close();
+    if (interval == 0) return false;
+
+    out = fopen(filename, (file_format == INTERVAL_BINARY) ? "wb" : "w");
+    if (out == NULL) return false;
+    setvbuf(out, NULL, _IOFBF, OUTPUT_BUFFER);
+
+    format = file_format;
+    length = interval;
+    last = origin.accesses;
+    head = START;
+    tail = START;
+    closing = false;
+    previous = origin;
+    written = START;
+
+    if (format == INTERVAL_BINARY) {
+        char header[INTERVAL_HEADER] = {0};
+        memcpy(header, INTERVAL_MAGIC, 4);
+        header[4] = INTERVAL_VERSION;
+        fwrite(header, 1, INTERVAL_HEADER, out);
+    }else{
+        fprintf(out, "interval,accesses,reads,read_misses,writes,write_misses,evictions,memory_writes\n");
+    }
+
+    writer = thread(&interval_log::drain, this);
+    return true;
+}
+
+void interval_log::close(){
+    if (out == NULL) return;
+    {
+        lock_guard<mutex> guard(lock);
+        closing = true;
+    }
+    wake.notify_one();
+    writer.join();
+    fclose(out);
+    out = NULL;
+}
+
+void interval_log::record(const interval_t &snapshot){
+    unsigned long long slot = head.load(memory_order_relaxed);
+
+    // the writer is a whole ring behind: wait for it
+    if (slot - tail.load(memory_order_acquire) == INTERVAL_RING) {
+        unique_lock<mutex> guard(lock);
+        wake.notify_one();
+        space.wait(guard, [this, slot](){ return slot - tail.load(memory_order_acquire) < INTERVAL_RING; });
+    }
+
+    ring[slot % INTERVAL_RING] = snapshot;
+    head.store(slot + 1, memory_order_release);
+    last = snapshot.accesses;
+
+    if ((slot + 1) % (INTERVAL_RING / 4) == 0) {
+        wake.notify_one();
+    }
+}
+
+void interval_log::emit(const interval_t &snapshot){
+    if (format == INTERVAL_BINARY) {
+        fwrite(&snapshot, sizeof(snapshot), 1, out);
+        return;
+    }
+
+    fprintf(out, "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", written, snapshot.accesses,
+            snapshot.reads - previous.reads, snapshot.rd_miss - previous.rd_miss,
+            snapshot.writes - previous.writes, snapshot.wr_miss - previous.wr_miss,
+            snapshot.eviction - previous.eviction, snapshot.memory - previous.memory);
+    previous = snapshot;
+    written++;
+}
+
+void interval_log::drain(){
+    for (;;) {
+        unsigned long long ready = head.load(memory_order_acquire);
+        unsigned long long done = tail.load(memory_order_relaxed);
+
+        if (done < ready) {
+            for (; done < ready; done++) {
+                emit(ring[done % INTERVAL_RING]);
+            }
+            tail.store(done, memory_order_release);
+            {
+                lock_guard<mutex> guard(lock);
+            }
+            space.notify_one();
+            continue;
+        }
+
+        unique_lock<mutex> guard(lock);
+        if (closing) {
+            if (head.load(memory_order_acquire) == done) break;
+            continue;
+        }
+        wake.wait_for(guard, chrono::milliseconds(WRITER_PERIOD));
+    }
+}
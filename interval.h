@@ -0,0 +1,109 @@
+#ifndef INTERVAL_H_
+#define INTERVAL_H_
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+typedef enum {INTERVAL_CSV, INTERVAL_BINARY} interval_format_t;
+
+/* counters at the end of an interval (cumulative since the start of the simulation) */
+typedef struct{
+    unsigned long long accesses;
+    unsigned long long reads;
+    unsigned long long rd_miss;
+    unsigned long long writes;
+    unsigned long long wr_miss;
+    unsigned long long eviction;
+    unsigned long long memory;
+} interval_t;
+
+/*
+* Interval file layouts:
+*   INTERVAL_CSV:    a header line, then one line per interval with the counter increments over the interval
+*                    ("interval,accesses,reads,read_misses,writes,write_misses,evictions,memory_writes",
+*                    accesses being the cumulative access count at the end of the interval)
+*   INTERVAL_BINARY: an 8-byte header (INTERVAL_MAGIC, version, 3 reserved bytes), then the raw interval_t
+*                    snapshots (cumulative, host byte order)
+*/
+#define INTERVAL_MAGIC "CINT"
+#define INTERVAL_VERSION 1
+#define INTERVAL_HEADER 8
+#define INTERVAL_RING 4096 //snapshots buffered between the simulation and the writer thread
+
+/*
+* Time series of the execution counters. The simulation copies a snapshot into a preallocated ring every
+* "interval" accesses; a background thread formats and writes the ring to the file, so the simulation
+* never waits on I/O unless the writer falls a whole ring behind.
+*/
+class interval_log{
+
+    /* single-producer/single-consumer ring of snapshots */
+    interval_t ring[INTERVAL_RING];
+    atomic<unsigned long long> head;   // snapshots recorded (simulation)
+    atomic<unsigned long long> tail;   // snapshots written (writer thread)
+
+    /* writer thread and its wake-ups */
+    thread writer;
+    mutex lock;
+    condition_variable wake;           // data to write, or closing
+    condition_variable space;          // the ring has room again
+    bool closing;
+
+    /* output file */
+    FILE *out;
+    interval_format_t format;
+    interval_t previous;               // last snapshot written (CSV increments)
+    unsigned long long written;        // snapshots written
+
+    /* interval length and access count of the last snapshot */
+    unsigned long long length;
+    unsigned long long last;
+
+    // writer thread: drains the ring until closed
+    void drain();
+
+    // writes one snapshot to the file
+    void emit(const interval_t &snapshot);
+
+    // logs are bound to their writer thread and are not copied
+    interval_log(const interval_log &);
+    interval_log &operator=(const interval_log &);
+
+public:
+
+    interval_log();
+
+    ~interval_log();
+
+    // creates "filename" and starts the writer; one snapshot every "interval" accesses counted from
+    // "origin", the counters when the log starts
+    bool open(const char *filename, unsigned long long interval, const interval_t &origin, interval_format_t format=INTERVAL_CSV);
+
+    // writes the pending snapshots, stops the writer and closes the file
+    void close();
+
+    // number of accesses per interval
+    unsigned long long get_interval(){
+        return length;
+    }
+
+    // accesses left before the next snapshot is due, given the current access count
+    unsigned long long remaining(unsigned long long accesses){
+        return length - (accesses - last);
+    }
+
+    // true when a snapshot was recorded at "accesses" already (nothing happened since)
+    bool recorded(unsigned long long accesses){
+        return accesses == last;
+    }
+
+    // queues a snapshot
+    void record(const interval_t &snapshot);
+};
+
+#endif /*INTERVAL_H_*/
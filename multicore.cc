@@ -0,0 +1,351 @@
+#include "multicore.h"
+#include <iostream>
+#include <thread>
+#include <stdlib.h>
+
+using namespace std;
+
+#define START 0x0
+#define MULTICORE_CHUNK (1 << 20) //accesses decoded per round of a parallel run
+
+directory::directory(size_t lines){
+    unsigned bits = 1;
+    while ((1ULL << bits) < 2ULL * lines) {
+        bits++;
+    }
+    directory_entry_t empty = {0, 0, 0};
+    table.assign(1ULL << bits, empty);
+    mask = (1ULL << bits) - 1;
+    shift = 64 - bits;
+}
+
+directory_entry_t *directory::insert(long long line){
+    uint64_t i = home(line);
+    for (;; i = (i + 1) & mask) {
+        directory_entry_t &entry = table[i];
+        if (entry.sharers == 0) break;
+        if (entry.line == line) return &entry;
+    }
+    table[i].line = line;
+    table[i].invalidated = START;
+    return &table[i];
+}
+
+void directory::erase(directory_entry_t *entry){
+    uint64_t hole = entry - table.data();
+
+    // pull back every following entry of the run whose home is not between the hole and itself
+    for (uint64_t i = (hole + 1) & mask; table[i].sharers != 0; i = (i + 1) & mask) {
+        uint64_t start = home(table[i].line);
+        if (((i - start) & mask) >= ((i - hole) & mask)) {
+            table[hole] = table[i];
+            hole = i;
+        }
+    }
+    table[hole].sharers = START;
+}
+
+multicore::multicore(unsigned core_count,
+                     unsigned size,
+                     unsigned associativity,
+                     unsigned line_size,
+                     unsigned hit_time,
+                     unsigned miss_penalty,
+                     unsigned address_width,
+                     replacement_policy_t replacement_policy
+){
+    if (core_count == 0 || core_count > MAX_CORES) {
+        cerr << "multi-core systems support 1 to " << MAX_CORES << " cores" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned c = START; c < core_count; c++) {
+        cores.push_back(new cache(size, associativity, line_size, WRITE_BACK, WRITE_ALLOCATE,
+                                  hit_time, miss_penalty, address_width, replacement_policy));
+    }
+    offset = cores[0]->offset;
+    unsigned sets = cores[0]->sized;
+
+    // every slice tracks whole sets of every core
+    unsigned count = (sets < DIRECTORY_SLICES) ? sets : DIRECTORY_SLICES;
+    slice_scale = ((unsigned long long)count << 32) / sets;
+    size_t lines = (size_t)core_count * ((sets + count - 1) / count) * cores[0]->coeval;
+    slices.assign(count, directory(lines));
+
+    core_stats_t empty = {};
+    totals.cores.assign(core_count, empty);
+    totals.memory_reads = START;
+    totals.memory_writes = START;
+    number_memory_accesses = START;
+    ignored = START;
+}
+
+multicore::~multicore(){
+    for (unsigned c = START; c < cores.size(); c++) {
+        delete cores[c];
+    }
+    cores.clear();
+}
+
+void multicore::load_trace(const char *filename, trace_mode_t mode){
+    if (!trace.open(filename, mode)){
+        cerr << "cannot open trace file " << filename << endl;
+    }
+}
+
+void multicore::load_trace(trace_source *source){
+    if (!trace.open(source)){
+        cerr << "cannot allocate the workload buffer" << endl;
+    }
+}
+
+void multicore::load_trace(const trace_entry_t *entries, size_t count){
+    trace.open(entries, count);
+}
+
+void multicore::run(unsigned num_entries){
+    unsigned long long first_access = number_memory_accesses;
+    trace_entry_t entry;
+
+    // run records (runs.h) are cut into single accesses, replayed at the address of the record
+    while (trace.next(entry, 1)) {
+        access(entry.core, entry.address, entry.op);
+
+        if ((num_entries != 0) && (number_memory_accesses - first_access) == num_entries) break;
+    }
+}
+
+void multicore::access(unsigned core, address_t address, trace_op_t op){
+    number_memory_accesses++;
+    if (core >= cores.size()) {
+        ignored++;
+        return;
+    }
+    step(core, address, op, totals);
+}
+
+void multicore::step(unsigned core, address_t address, trace_op_t op, shard_t &shard){
+    cache *own = cores[core];
+    core_stats_t &s = shard.cores[core];
+    directory &slice_directory = slices[slice(address)];
+    long long line = address >> offset;
+    uint64_t me = 1ULL << core;
+    bool write = (op == TRACE_WRITE);
+
+    write ? s.writes++ : s.reads++;
+    int way = own->probe(address);
+    if (way >= 0) {
+        if (write) {
+            // S -> M: the other copies go (E -> M is silent)
+            directory_entry_t *entry = slice_directory.find(line);
+            uint64_t others = entry->sharers & ~me;
+            if (others) {
+                s.upgrades++;
+                for (uint64_t rest = others; rest; rest &= rest - 1) {
+                    unsigned k = __builtin_ctzll(rest);
+                    bool dirty;
+                    cores[k]->invalidate(address, dirty);
+                    shard.cores[k].invalidations++;
+                }
+                entry->invalidated |= others;
+                entry->sharers = me;
+            }
+        }
+        own->touch(address, way, write);
+        return;
+    }
+
+    write ? s.wr_miss++ : s.rd_miss++;
+    directory_entry_t *entry = slice_directory.insert(line);
+    if (entry->invalidated & me) {
+        s.coherence_misses++;
+        entry->invalidated &= ~me;
+    }
+
+    uint64_t others = entry->sharers & ~me;
+    if (others == 0) {
+        shard.memory_reads++;
+        entry->sharers = me;
+    }else if (write) {
+        // the copies are invalidated; a modified one moves over with the line
+        s.transfers++;
+        for (uint64_t rest = others; rest; rest &= rest - 1) {
+            unsigned k = __builtin_ctzll(rest);
+            bool dirty;
+            cores[k]->invalidate(address, dirty);
+            shard.cores[k].invalidations++;
+        }
+        entry->invalidated |= others;
+        entry->sharers = me;
+    }else{
+        // only a sole holder (E or M) can be dirty: M -> S writes it back
+        s.transfers++;
+        if ((others & (others - 1)) == 0) {
+            unsigned k = __builtin_ctzll(others);
+            if (cores[k]->clean(address)) {
+                shard.memory_writes++;
+                shard.cores[k].writebacks++;
+            }
+        }
+        entry->sharers |= me;
+    }
+
+    // the victim leaves the directory (it maps to the same set, so to the same slice)
+    address_t victim;
+    bool victim_dirty;
+    if (own->install(address, write, victim, victim_dirty)) {
+        s.eviction++;
+        directory_entry_t *held = slice_directory.find(victim >> offset);
+        held->sharers &= ~me;
+        if (held->sharers == 0) slice_directory.erase(held);
+        if (victim_dirty) {
+            shard.memory_writes++;
+            s.writebacks++;
+        }
+    }
+}
+
+void multicore::merge(const shard_t &shard){
+    for (unsigned c = START; c < cores.size(); c++) {
+        const core_stats_t &from = shard.cores[c];
+        core_stats_t &to = totals.cores[c];
+        to.reads += from.reads;
+        to.rd_miss += from.rd_miss;
+        to.writes += from.writes;
+        to.wr_miss += from.wr_miss;
+        to.coherence_misses += from.coherence_misses;
+        to.upgrades += from.upgrades;
+        to.invalidations += from.invalidations;
+        to.transfers += from.transfers;
+        to.eviction += from.eviction;
+        to.writebacks += from.writebacks;
+    }
+    totals.memory_reads += shard.memory_reads;
+    totals.memory_writes += shard.memory_writes;
+}
+
+/*
+* The main thread decodes the trace one chunk ahead of the workers; every worker walks the whole chunk
+* and simulates, in trace order, the accesses that fall in its own directory slices.
+*/
+void multicore::run_parallel(unsigned threads, unsigned num_entries){
+    if (threads > slices.size()) {
+        threads = slices.size();
+    }
+    if (threads <= 1) {
+        run(num_entries);
+        return;
+    }
+
+    vector<unsigned char> owner(slices.size());
+    for (unsigned i = START; i < slices.size(); i++) {
+        owner[i] = (unsigned long long)i * threads / slices.size();
+    }
+
+    core_stats_t empty = {};
+    vector<shard_t> shards(threads);
+    for (unsigned w = START; w < threads; w++) {
+        shards[w].cores.assign(cores.size(), empty);
+        shards[w].memory_reads = START;
+        shards[w].memory_writes = START;
+    }
+
+    vector<trace_entry_t> buffers[2];
+    unsigned long long decoded = START;
+    trace_entry_t entry;
+    auto decode = [&](vector<trace_entry_t> &buffer){
+        buffer.clear();
+        while (buffer.size() < MULTICORE_CHUNK) {
+            if ((num_entries != 0) && decoded == num_entries) break;
+            if (!trace.next(entry, 1)) break;
+            decoded++;
+            if (entry.core >= cores.size()) {
+                ignored++;
+                continue;
+            }
+            buffer.push_back(entry);
+        }
+    };
+
+    unsigned current = START;
+    decode(buffers[current]);
+    while (!buffers[current].empty()) {
+        const vector<trace_entry_t> &chunk = buffers[current];
+        vector<thread> workers;
+        for (unsigned w = START; w < threads; w++) {
+            workers.push_back(thread([&, w](){
+                for (size_t i = START; i < chunk.size(); i++) {
+                    const trace_entry_t &access = chunk[i];
+                    if (owner[slice(access.address)] == w) step(access.core, access.address, access.op, shards[w]);
+                }
+            }));
+        }
+        decode(buffers[1 - current]);
+        for (unsigned w = START; w < threads; w++) {
+            workers[w].join();
+        }
+        current = 1 - current;
+    }
+    number_memory_accesses += decoded;
+
+    for (unsigned w = START; w < threads; w++) {
+        merge(shards[w]);
+    }
+}
+
+void multicore::print_configuration(){
+    cout << "MULTICORE CONFIGURATION" << endl;
+    cout << "cores = " << cores.size() << endl;
+    cout << "coherence protocol = MESI (directory)" << endl;
+    cout << endl << "PRIVATE CACHE (each core)" << endl;
+    cores[0]->print_configuration();
+}
+
+core_stats_t multicore::get_core_statistics(unsigned core){
+    return totals.cores[core];
+}
+
+float multicore::amat(){
+    unsigned long long demand = START;
+    unsigned long long misses = START;
+
+    for (unsigned c = START; c < cores.size(); c++) {
+        const core_stats_t &s = totals.cores[c];
+        demand += s.reads + s.writes;
+        misses += s.rd_miss + s.wr_miss;
+    }
+    float miss_rate = demand ? float(misses) / demand : 0;
+    return cores[0]->hitT + miss_rate * cores[0]->penalty;
+}
+
+void multicore::print_statistics(){
+    unsigned long long invalidations = START;
+
+    cout << "STATISTICS" << endl;
+    cout << "memory accesses = " << dec << number_memory_accesses << endl;
+    for (unsigned c = START; c < cores.size(); c++) {
+        const core_stats_t &s = totals.cores[c];
+        unsigned long long demand = s.reads + s.writes;
+
+        cout << "CORE " << c << endl;
+        cout << "read = " << s.reads << endl;
+        cout << "read misses = " << s.rd_miss << endl;
+        cout << "write = " << s.writes << endl;
+        cout << "write misses = " << s.wr_miss << endl;
+        cout << "coherence misses = " << s.coherence_misses << endl;
+        cout << "upgrades = " << s.upgrades << endl;
+        cout << "invalidations received = " << s.invalidations << endl;
+        cout << "cache-to-cache transfers = " << s.transfers << endl;
+        cout << "evictions = " << s.eviction << endl;
+        cout << "write-backs = " << s.writebacks << endl;
+        cout << "miss rate = " << (demand ? float(s.rd_miss + s.wr_miss) / demand : 0) << endl;
+        invalidations += s.invalidations;
+    }
+    cout << "invalidations = " << invalidations << endl;
+    cout << "memory reads = " << totals.memory_reads << endl;
+    cout << "memory writes = " << totals.memory_writes << endl;
+    if (ignored) {
+        cout << "ignored accesses (unknown core) = " << ignored << endl;
+    }
+    cout << "average memory access time = " << amat() << endl;
+}
@@ -0,0 +1,166 @@
+#ifndef MULTICORE_H_
+#define MULTICORE_H_
+
+#include <vector>
+#include <stdint.h>
+#include "cache.h"
+
+using namespace std;
+
+#define MAX_CORES 64          //cores of a multi-core system (one bit each in the directory)
+#define DIRECTORY_SLICES 64   //largest number of directory slices (and of worker threads)
+
+/* per-core statistics of a multi-core system */
+typedef struct{
+    unsigned long long reads;
+    unsigned long long rd_miss;
+    unsigned long long writes;
+    unsigned long long wr_miss;
+    unsigned long long coherence_misses;  // misses on lines this core lost to another core's write
+    unsigned long long upgrades;          // write hits on lines shared with other cores
+    unsigned long long invalidations;     // lines of this core invalidated by other cores' writes
+    unsigned long long transfers;         // misses served by another core's cache instead of memory
+    unsigned long long eviction;
+    unsigned long long writebacks;        // dirty lines written to memory (evicted or downgraded)
+} core_stats_t;
+
+/* directory entry of a line held by at least one core */
+typedef struct{
+    long long line;             // line address (address >> offset)
+    uint64_t sharers;           // cores holding the line (0: empty bucket)
+    uint64_t invalidated;       // cores that lost it to another core's write since
+} directory_entry_t;
+
+/*
+* One slice of the directory: an open-addressing hash table of the lines cached by any core, sized once
+* for every line the slice can track, with linear probing and backward-shift deletion.
+*/
+class directory{
+
+    vector<directory_entry_t> table;
+    uint64_t mask;
+    unsigned shift;
+
+    uint64_t home(long long line){
+        return ((uint64_t)line * 0x9E3779B97F4A7C15ULL) >> shift;
+    }
+
+public:
+
+    // room for "lines" lines
+    directory(size_t lines);
+
+    // entry of "line", or NULL when no core holds it
+    directory_entry_t *find(long long line){
+        for (uint64_t i = home(line);; i = (i + 1) & mask) {
+            directory_entry_t &entry = table[i];
+            if (entry.sharers == 0) return NULL;
+            if (entry.line == line) return &entry;
+        }
+    }
+
+    // entry of "line", added with no sharers when missing (the caller sets them before any other call)
+    directory_entry_t *insert(long long line);
+
+    // removes "entry" (other entries may move)
+    void erase(directory_entry_t *entry);
+};
+
+/*
+* Multi-core system: one private cache per core (write-back, write-allocate, all of the same geometry)
+* kept coherent with MESI through a directory. The trace carries the core of every access (trace.h).
+* Per line and core the MESI state follows from the private tag array and the directory:
+*   M: valid and dirty; E: valid, clean and the only sharer; S: valid with other sharers; I: not cached.
+* A read miss takes the line from another core when one holds it (a modified copy is written back and
+* downgraded to S) and from memory otherwise; a write invalidates every other copy (a modified copy
+* moves to the writer without reaching memory). Coherence never crosses set indexes, so the directory
+* is split in slices of whole set ranges and run_parallel gives every worker its own slices of every core:
+* workers share no state and need no locks, and results are identical to the serial run.
+*/
+class multicore{
+
+    /* number of memory accesses processed */
+    unsigned long long number_memory_accesses;
+
+    /* trace file reader */
+    trace_reader trace;
+
+    /* private caches (owned) and directory slices */
+    vector<cache *> cores;
+    vector<directory> slices;
+
+    /* geometry shared by the caches; a slice holds the sets (set * slices.size()) >> 32 maps to */
+    unsigned offset;
+    unsigned long long slice_scale;
+
+    /* statistics of one worker (or of the whole system) */
+    typedef struct{
+        vector<core_stats_t> cores;
+        unsigned long long memory_reads;
+        unsigned long long memory_writes;
+    } shard_t;
+
+    shard_t totals;
+    unsigned long long ignored;
+
+    unsigned slice(address_t address){
+        return (cores[0]->set_of(address) * slice_scale) >> 32;
+    }
+
+    // processes one access of "core", charging "shard"
+    void step(unsigned core, address_t address, trace_op_t op, shard_t &shard);
+
+    // adds the counters of "shard" to the totals
+    void merge(const shard_t &shard);
+
+    // multi-core systems own their caches and are not copied
+    multicore(const multicore &);
+    multicore &operator=(const multicore &);
+
+public:
+
+    multicore(unsigned core_count,          // number of cores (up to MAX_CORES)
+              unsigned cache_size,          // private cache size (in bytes)
+              unsigned cache_associativity, // private cache associativity
+              unsigned cache_line_size,     // cache block size (in bytes)
+              unsigned cache_hit_time,      // cache hit time (in clock cycles)
+              unsigned cache_miss_penalty,  // cache miss penalty (in clock cycles)
+              unsigned address_width,       // number of bits in memory address
+              replacement_policy_t replacement_policy=REPLACE_LRU
+    );
+
+    ~multicore();
+
+    // loads the trace file (with name "filename") so that it can be used by the "run" function
+    void load_trace(const char *filename, trace_mode_t mode=TRACE_MMAP);
+
+    // reads the accesses generated by "source", which must outlive the run
+    void load_trace(trace_source *source);
+
+    // uses "count" accesses already decoded in memory as the trace; the array is shared, not copied
+    void load_trace(const trace_entry_t *entries, size_t count);
+
+    // processes "num_memory_accesses" memory accesses from the input trace (all of them when 0);
+    // accesses of cores beyond the configured ones are counted and ignored
+    void run(unsigned num_memory_accesses=0);
+
+    // same as run, with the directory slices split among "threads" worker threads
+    void run_parallel(unsigned threads, unsigned num_memory_accesses=0);
+
+    // processes one access of "core"
+    void access(unsigned core, address_t address, trace_op_t op);
+
+    // prints the number of cores and the configuration of their caches
+    void print_configuration();
+
+    // prints the per-core statistics, the memory traffic and the average memory access time
+    void print_statistics();
+
+    // statistics of core "core"
+    core_stats_t get_core_statistics(unsigned core);
+
+    // average memory access time over all cores
+    float amat();
+};
+
+#endif /*MULTICORE_H_*/
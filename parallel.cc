@@ -0,0 +1,195 @@
+#include "cache.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+#define START 0x0
+#define SHARD_CHUNK (1 << 20) //accesses decoded per round of a sharded run
+
+/* reusable barrier for a fixed number of threads */
+class thread_barrier{
+
+    mutex lock;
+    condition_variable released;
+    unsigned parties;
+    unsigned waiting;
+    unsigned long long generation;
+
+public:
+
+    thread_barrier(unsigned count){
+        parties = count;
+        waiting = START;
+        generation = START;
+    }
+
+    void wait(){
+        unique_lock<mutex> guard(lock);
+        unsigned long long arrival = generation;
+        if (++waiting == parties) {
+            waiting = START;
+            generation++;
+            released.notify_all();
+            return;
+        }
+        released.wait(guard, [this, arrival](){ return generation != arrival; });
+    }
+};
+
+/*
+* Sets never interact, so each worker owns a contiguous range of sets and replays, in trace order, only
+* the accesses that map to it. The main thread decodes the trace in chunks, one chunk ahead of the
+* workers; per chunk the workers (1) tag their slice of the chunk with the owning worker, (2) scatter
+* the access indices into per-owner lists, keeping trace order, and (3) simulate their own list.
+* Replacement state is per set and sees its accesses in trace order, so the tag array ends up identical
+* to the serial run.
+*/
+void cache::run_parallel(unsigned threads, unsigned num_entries){
+    if (threads > sized) {
+        threads = sized;
+    }
+    if (threads <= 1) {
+        run(num_entries);
+        return;
+    }
+
+    vector<trace_entry_t> buffers[2];
+    vector<unsigned> owner(SHARD_CHUNK);
+    vector<unsigned> list(SHARD_CHUNK);
+    vector<size_t> slice_count((size_t)threads * threads);
+    vector<counters_t> shard(threads, counters_t());
+
+    /* worker of a set: set * threads / sized, as a 32-bit fixed-point product (sets are below 2^32) */
+    const unsigned long long owner_scale = ((unsigned long long)threads << 32) / sized;
+
+    /* chunk being simulated */
+    const trace_entry_t *chunk = NULL;
+    size_t chunk_size = START;
+
+    thread_barrier start(threads + 1);
+    thread_barrier phase(threads);
+    thread_barrier done(threads + 1);
+
+    vector<thread> workers;
+    for (unsigned w = START; w < threads; w++) {
+        workers.push_back(thread([&, w](){
+            vector<size_t> cursor(threads);
+
+            for (;;) {
+                start.wait();
+                if (chunk_size == 0) return;
+
+                // (1) owner of every access of this worker's slice
+                size_t lo = chunk_size * w / threads;
+                size_t hi = chunk_size * (w + 1) / threads;
+                size_t *mine = &slice_count[(size_t)w * threads];
+                for (unsigned d = START; d < threads; d++) {
+                    mine[d] = START;
+                }
+                for (size_t i = lo; i < hi; i++) {
+                    unsigned d = (set_of(chunk[i].address) * owner_scale) >> 32;
+                    owner[i] = d;
+                    mine[d]++;
+                }
+                phase.wait();
+
+                // (2) owner lists are laid out one after the other, each in slice (= trace) order
+                size_t base = START;
+                size_t own_base = START;
+                size_t own_size = START;
+                for (unsigned d = START; d < threads; d++) {
+                    size_t before = START;
+                    size_t total = START;
+                    for (unsigned s = START; s < threads; s++) {
+                        if (s == w) before = total;
+                        total += slice_count[(size_t)s * threads + d];
+                    }
+                    cursor[d] = base + before;
+                    if (d == w) {
+                        own_base = base;
+                        own_size = total;
+                    }
+                    base += total;
+                }
+                for (size_t i = lo; i < hi; i++) {
+                    list[cursor[owner[i]]++] = i;
+                }
+                phase.wait();
+
+                // (3) this worker's sets
+                (this->*shard_kernel)(chunk, &list[own_base], own_size, shard[w]);
+                done.wait();
+            }
+        }));
+    }
+
+    unsigned current = START;
+    trace_entry_t entry;
+
+    /* decodes the next chunk of at most SHARD_CHUNK accesses, stopping at "num_entries" accesses in total */
+    /* with an interval log, chunks also end where snapshots are due ("mark", in accesses since the start) */
+    /* run records are cut at these limits; "accessed" holds the accesses of each buffer */
+    size_t decoded = START;
+    bool trace_end = false;
+    unsigned long long mark = (intervals != NULL) ? intervals->remaining(number_memory_accesses) : 0;
+    size_t accessed[2] = {START, START};
+    auto decode = [&](unsigned b){
+        vector<trace_entry_t> &buffer = buffers[b];
+        size_t limit = SHARD_CHUNK;
+        if (intervals != NULL) {
+            if (decoded == mark) mark += intervals->get_interval();
+            if (mark - decoded < limit) limit = mark - decoded;
+        }
+        if ((num_entries != 0) && num_entries - decoded < limit) limit = num_entries - decoded;
+        buffer.clear();
+        size_t taken = START;
+        while (taken < limit) {
+            if (!trace.next(entry, limit - taken)) {
+                trace_end = true;
+                break;
+            }
+            buffer.push_back(entry);
+            taken += trace_accesses(entry);
+        }
+        decoded += taken;
+        accessed[b] = taken;
+    };
+
+    decode(current);
+    for (;;) {
+        chunk = buffers[current].data();
+        chunk_size = buffers[current].size();
+        start.wait();
+        if (chunk_size == 0) break;
+
+        decode(1 - current);
+        done.wait();
+
+        number_memory_accesses += accessed[current];
+        current = 1 - current;
+
+        if (intervals != NULL && intervals->remaining(number_memory_accesses) == 0) {
+            intervals->record(snapshot(shard.data(), threads));
+        }
+    }
+
+    for (unsigned w = START; w < threads; w++) {
+        workers[w].join();
+
+        counters.reads += shard[w].reads;
+        counters.rd_miss += shard[w].rd_miss;
+        counters.writes += shard[w].writes;
+        counters.wr_miss += shard[w].wr_miss;
+        counters.eviction += shard[w].eviction;
+        counters.hits += shard[w].hits;
+        counters.memory += shard[w].memory;
+        PROFILE_MERGE(counters, shard[w]);
+    }
+
+    // the trace ended inside an interval
+    if (intervals != NULL && trace_end && !intervals->recorded(number_memory_accesses)) {
+        intervals->record(snapshot(NULL, 0));
+    }
+}
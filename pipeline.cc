@@ -0,0 +1,214 @@
+#include "pipeline.h"
+#include "compress.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+
+#define START 0x0
+#define SPINS 64 //yields before a waiting decoder starts sleeping
+
+trace_pipeline::trace_pipeline(){
+    stopping = false;
+    fd = -1;
+    map = NULL;
+    size = START;
+    sequential = NULL;
+    format = TRACE_TEXT;
+    block = START;
+    holding = false;
+}
+
+trace_pipeline::~trace_pipeline(){
+    close();
+}
+
+bool trace_pipeline::open(const char *name, unsigned threads){
+    struct stat info;
+
+    close();
+    fd = ::open(name, O_RDONLY);
+    if (fd < 0) return false;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            map = (char *)mapping;
+            size = info.st_size;
+        }
+    }
+
+    if (map != NULL) {
+        bool binary = size >= TRACE_HEADER && !memcmp(map, TRACE_MAGIC, 4) && map[4] == TRACE_VERSION;
+        format = binary ? TRACE_BINARY : TRACE_TEXT;
+    }
+
+    if (threads == 0) {
+        unsigned spare = thread::hardware_concurrency();
+        threads = (spare > 1) ? spare - 1 : 1;
+        if (threads > PIPELINE_DECODERS) threads = PIPELINE_DECODERS;
+    }
+    // compressed traces cannot be cut into blocks: the sequential reader decompresses them
+    bool compressed = (map != NULL && detect_compression((const unsigned char *)map, size) != COMPRESSION_NONE);
+    bool parallel = (map != NULL && format == TRACE_TEXT && !compressed);
+    if (!parallel) {
+        // the single decoder reads through its own reader, opened here so that the format is known
+        threads = 1;
+        sequential = new trace_reader();
+        if (!sequential->open(name, (map != NULL) ? TRACE_MMAP : TRACE_STREAM)) {
+            close();
+            return false;
+        }
+        format = sequential->get_format();
+        if (map != NULL) {
+            munmap(map, size);
+            map = NULL;
+            size = START;
+        }
+    }
+
+    stopping = false;
+    block = START;
+    holding = false;
+    for (unsigned d = START; d < threads; d++) {
+        ring_t *ring = new ring_t();
+        ring->head = START;
+        ring->tail = START;
+        rings.push_back(ring);
+    }
+    for (unsigned d = START; d < threads; d++) {
+        if (parallel) {
+            decoders.push_back(thread(&trace_pipeline::decode_blocks, this, d));
+        }else{
+            decoders.push_back(thread(&trace_pipeline::decode_sequential, this));
+        }
+    }
+    return true;
+}
+
+void trace_pipeline::close(){
+    stopping = true;
+    for (unsigned d = START; d < decoders.size(); d++) {
+        decoders[d].join();
+    }
+    for (unsigned d = START; d < rings.size(); d++) {
+        delete rings[d];
+    }
+    decoders.clear();
+    rings.clear();
+    delete sequential;
+    sequential = NULL;
+
+    if (map != NULL) munmap(map, size);
+    if (fd >= 0) ::close(fd);
+    map = NULL;
+    size = START;
+    fd = -1;
+}
+
+trace_pipeline::chunk_t *trace_pipeline::reserve(ring_t &ring){
+    unsigned long long head = ring.head.load(memory_order_relaxed);
+    unsigned spins = START;
+
+    while (head - ring.tail.load(memory_order_acquire) == PIPELINE_SLOTS) {
+        if (stopping) return NULL;
+        if (++spins < SPINS) {
+            this_thread::yield();
+        }else{
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+    return &ring.slot[head % PIPELINE_SLOTS];
+}
+
+void trace_pipeline::publish(ring_t &ring){
+    ring.head.store(ring.head.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+void trace_pipeline::decode_sequential(){
+    trace_reader &reader = *sequential;
+    trace_entry_t entry;
+    ring_t &ring = *rings[0];
+
+    for (;;) {
+        chunk_t *chunk = reserve(ring);
+        if (chunk == NULL) return;
+
+        chunk->entries.resize(PIPELINE_CHUNK);
+        size_t n = START;
+        while (n < PIPELINE_CHUNK && reader.next(entry)) {
+            chunk->entries[n++] = entry;
+        }
+        chunk->entries.resize(n);
+        chunk->end = (n == 0);
+        publish(ring);
+        if (chunk->end) return;
+    }
+}
+
+void trace_pipeline::decode_blocks(unsigned decoder){
+    ring_t &ring = *rings[decoder];
+    unsigned long long blocks = (size + PIPELINE_BLOCK - 1) / PIPELINE_BLOCK;
+    trace_reader reader;
+    trace_entry_t entry;
+
+    // first character of the first line starting in block "b"
+    auto boundary = [this](unsigned long long b) -> size_t {
+        if (b == 0) return 0;
+        size_t position = b * PIPELINE_BLOCK;
+        if (position >= size) return size;
+        const char *line = (const char *)memchr(map + position - 1, '\n', size - position + 1);
+        return (line != NULL) ? line + 1 - map : size;
+    };
+
+    for (unsigned long long b = decoder;; b += rings.size()) {
+        chunk_t *chunk = reserve(ring);
+        if (chunk == NULL) return;
+
+        chunk->entries.clear();
+        chunk->end = (b >= blocks);
+        if (!chunk->end) {
+            size_t begin = boundary(b);
+            size_t end = boundary(b + 1);
+            reader.open(map + begin, end - begin);
+            while (reader.next(entry)) {
+                chunk->entries.push_back(entry);
+            }
+        }
+        publish(ring);
+        if (chunk->end) return;
+    }
+}
+
+bool trace_pipeline::next(const trace_entry_t *&entries, size_t &count){
+    unsigned lanes = rings.size();
+    if (lanes == 0) return false;
+
+    if (holding) {
+        ring_t &previous = *rings[(block - 1) % lanes];
+        previous.tail.store(previous.tail.load(memory_order_relaxed) + 1, memory_order_release);
+        holding = false;
+    }
+
+    ring_t &ring = *rings[block % lanes];
+    unsigned long long tail = ring.tail.load(memory_order_relaxed);
+    while (ring.head.load(memory_order_acquire) == tail) {
+        this_thread::yield();
+    }
+
+    chunk_t &chunk = ring.slot[tail % PIPELINE_SLOTS];
+    if (chunk.end) return false;
+
+    block++;
+    holding = true;
+    entries = chunk.entries.data();
+    count = chunk.entries.size();
+    return true;
+}
+
+trace_format_t trace_pipeline::get_format(){
+    return format;
+}
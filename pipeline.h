@@ -0,0 +1,88 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "trace.h"
+
+using namespace std;
+
+#define PIPELINE_BLOCK (1 << 20) //bytes of text decoded as one block by the parallel decoders
+#define PIPELINE_CHUNK (1 << 16) //accesses per chunk when the trace is decoded sequentially
+#define PIPELINE_SLOTS 4         //decoded chunks buffered per decoder
+#define PIPELINE_DECODERS 4      //largest default number of decoder threads
+
+/*
+* Trace decoding ahead of the simulation (TRACE_PIPELINE mode of trace_reader).
+* Decoder threads parse the trace into chunks of accesses and publish them on lock-free single-producer/
+* single-consumer rings, one per decoder; the simulation thread takes the chunks in trace order and
+* walks them in place.
+* Mapped text traces are cut into PIPELINE_BLOCK blocks (each line belongs to the block holding its
+* first character) dealt round-robin to the decoders, so block k is always on ring k % decoders.
+* Binary traces (delta encoded), compressed traces and unmappable files are decoded sequentially by a
+* single decoder.
+*/
+class trace_pipeline{
+
+    typedef struct{
+        vector<trace_entry_t> entries;
+        bool end;                          // no chunk follows on this ring
+    } chunk_t;
+
+    typedef struct{
+        chunk_t slot[PIPELINE_SLOTS];
+        alignas(64) atomic<unsigned long long> head;  // chunks published (decoder)
+        alignas(64) atomic<unsigned long long> tail;  // chunks released (simulation)
+    } ring_t;
+
+    vector<ring_t *> rings;
+    vector<thread> decoders;
+    atomic<bool> stopping;
+
+    /* input: the mapping shared by the block decoders, or the reader of the sequential one */
+    int fd;
+    char *map;
+    size_t size;
+    trace_reader *sequential;
+    trace_format_t format;
+
+    /* simulation side: next block to take and whether it holds the slot of the previous one */
+    unsigned long long block;
+    bool holding;
+
+    // waits for a free slot of "ring"; returns NULL when the pipeline is closing
+    chunk_t *reserve(ring_t &ring);
+
+    // publishes the reserved slot of "ring"
+    void publish(ring_t &ring);
+
+    // decoder threads
+    void decode_blocks(unsigned decoder);
+    void decode_sequential();
+
+    // pipelines own threads and are not copied
+    trace_pipeline(const trace_pipeline &);
+    trace_pipeline &operator=(const trace_pipeline &);
+
+public:
+
+    trace_pipeline();
+
+    ~trace_pipeline();
+
+    // starts decoding "filename" with up to "threads" decoders (0: one per spare hardware thread, at
+    // most PIPELINE_DECODERS)
+    bool open(const char *filename, unsigned threads=0);
+
+    // stops the decoders and releases the input
+    void close();
+
+    // releases the previous chunk and returns the next one in trace order; false at the end of the trace
+    bool next(const trace_entry_t *&entries, size_t &count);
+
+    // format of the trace
+    trace_format_t get_format();
+};
+
+#endif /*PIPELINE_H_*/
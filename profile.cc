@@ -0,0 +1,36 @@
+#include "profile.h"
+#include <iostream>
+
+using namespace std;
+
+#define START 0x0
+
+const char *profile_phase_name(profile_phase_t phase){
+    static const char *names[PROFILE_PHASES] = {"parse", "lookup", "allocate", "evict"};
+    return (phase < PROFILE_PHASES) ? names[phase] : "unknown";
+}
+
+void profile_merge(profile_t &to, const profile_t &from){
+    for (unsigned p = START; p < PROFILE_PHASES; p++) {
+        to.cycles[p] += from.cycles[p];
+        to.calls[p] += from.calls[p];
+    }
+    for (unsigned w = START; w <= PROFILE_WAYS; w++) {
+        to.ways[w] += from.ways[w];
+    }
+}
+
+void profile_print(const profile_t &profile){
+    cout << "PROFILE" << endl;
+    for (unsigned p = START; p < PROFILE_PHASES; p++) {
+        cout << profile_phase_name((profile_phase_t)p) << " = " << dec << profile.calls[p] << " calls, "
+             << profile.cycles[p] << " cycles";
+        if (profile.calls[p]) cout << ", " << (double)profile.cycles[p] / profile.calls[p] << " per call";
+        cout << endl;
+    }
+    cout << "ways scanned per lookup" << endl;
+    for (unsigned w = START; w <= PROFILE_WAYS; w++) {
+        if (profile.ways[w] == 0) continue;
+        cout << w << ((w == PROFILE_WAYS) ? "+" : "") << " = " << profile.ways[w] << endl;
+    }
+}
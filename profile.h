@@ -0,0 +1,72 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <time.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+/*
+* Hot-path profiler, compiled in with -DCACHE_PROFILE (make PROFILE=1) and absent otherwise: the
+* PROFILE_* macros below expand to nothing and counters_t carries no profile, so a normal build runs
+* exactly the same code as before.
+* Phases: PARSE is the decoding of one trace entry by run(), LOOKUP the tag search of one access,
+* ALLOCATE the fill of a missing line (victim selection and write-back included), EVICT the victim
+* selection alone. Every phase counts its calls and the cycles between its ends (rdtsc, or nanoseconds
+* on hosts without a time-stamp counter), the timer calls themselves included.
+* Lookups are also binned by the number of ways they compared: the hit way + 1 on a hit, all ways on a
+* miss, one for the hashed fully-associative lookup.
+*/
+typedef enum {PROFILE_PARSE, PROFILE_LOOKUP, PROFILE_ALLOCATE, PROFILE_EVICT, PROFILE_PHASES} profile_phase_t;
+
+#define PROFILE_WAYS 64 //last bin of the ways-scanned histogram (it also holds every longer scan)
+
+typedef struct{
+    unsigned long long cycles[PROFILE_PHASES];
+    unsigned long long calls[PROFILE_PHASES];
+    unsigned long long ways[PROFILE_WAYS + 1];   // lookups by number of ways compared
+} profile_t;
+
+// name of "phase", as printed
+const char *profile_phase_name(profile_phase_t phase);
+
+// adds the counts of "from" to "to"
+void profile_merge(profile_t &to, const profile_t &from);
+
+// prints the phases (calls, cycles, cycles per call) and the non-empty bins of the histogram
+void profile_print(const profile_t &profile);
+
+static inline unsigned long long profile_clock(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+#ifdef CACHE_PROFILE
+#define PROFILE_START(start) unsigned long long start = profile_clock()
+#define PROFILE_STOP(count, phase, start) do { \
+        (count).profile.cycles[phase] += profile_clock() - (start); \
+        (count).profile.calls[phase]++; \
+    } while (0)
+#define PROFILE_SCAN(count, scanned) do { \
+        unsigned long long bin = (scanned); \
+        (count).profile.ways[(bin < PROFILE_WAYS) ? bin : PROFILE_WAYS]++; \
+    } while (0)
+#define PROFILE_MERGE(to, from) profile_merge((to).profile, (from).profile)
+#define PROFILE_RESET(count) memset(&(count).profile, 0, sizeof(profile_t))
+#else
+#define PROFILE_START(start)
+#define PROFILE_STOP(count, phase, start)
+#define PROFILE_SCAN(count, scanned)
+#define PROFILE_MERGE(to, from)
+#define PROFILE_RESET(count)
+#endif
+
+#endif /*PROFILE_H_*/
@@ -0,0 +1,18 @@
+#include "replacement.h"
+#include <string.h>
+
+static const char *names[] = {"lru", "plru", "srrip", "brrip", "random"};
+
+const char *replacement_name(replacement_policy_t policy){
+    return names[policy];
+}
+
+bool replacement_parse(const char *name, replacement_policy_t &policy){
+    for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!strcmp(name, names[i])) {
+            policy = (replacement_policy_t)i;
+            return true;
+        }
+    }
+    return false;
+}
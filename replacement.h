@@ -0,0 +1,274 @@
+#ifndef REPLACEMENT_H_
+#define REPLACEMENT_H_
+
+#include <stdint.h>
+
+/*
+* Replacement policies of the tag array.
+* Every policy keeps its state in a small per-set metadata area of the set block (see cache.h) and
+* exposes the same static operations on it:
+*   bytes(ways)          size of the metadata area
+*   reset(meta, ways, set) initial state of one set
+*   hit(meta, ways, way)   "way" was accessed
+*   insert(meta, ways, way) "way" was just filled
+*   victim(meta, ways)     way to replace once the set is full
+* None of them relies on a global access counter, so long traces cannot wrap their state.
+* Invalid ways are always filled first by the cache; victim is only asked for full sets.
+*/
+
+typedef enum {REPLACE_LRU, REPLACE_PLRU, REPLACE_SRRIP, REPLACE_BRRIP, REPLACE_RANDOM} replacement_policy_t;
+
+#define MAX_BIT_WAYS 64 //associativity limit of the bit-vector policies (PLRU, SRRIP, BRRIP)
+
+/* xorshift32 step: the per-set random source of BRRIP and random replacement */
+static inline uint32_t replacement_random(uint32_t &seed){
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/* non-zero seed of one set, so runs are reproducible and independent of the set visiting order */
+static inline uint32_t replacement_seed(unsigned long long set){
+    uint32_t seed = (uint32_t)((set + 1) * 0x9E3779B97F4A7C15ULL >> 32);
+    return seed ? seed : 1;
+}
+
+/*
+* true LRU: the ways of a set form a doubly linked recency list, most recent at the head
+* a hit or a fill moves the way to the head, the victim is the tail; both O(1)
+*/
+struct lru_policy{
+
+    typedef struct{
+        uint16_t head;
+        uint16_t tail;
+    } ends_t;
+
+    static unsigned bytes(unsigned ways){
+        return sizeof(ends_t) + 2 * ways * sizeof(uint16_t);
+    }
+
+    static uint16_t *prev(unsigned char *meta){
+        return (uint16_t *)(meta + sizeof(ends_t));
+    }
+
+    static uint16_t *next(unsigned char *meta, unsigned ways){
+        return prev(meta) + ways;
+    }
+
+    static void reset(unsigned char *meta, unsigned ways, unsigned long long){
+        ends_t *ends = (ends_t *)meta;
+        uint16_t *before = prev(meta);
+        uint16_t *after = next(meta, ways);
+
+        ends->head = 0;
+        ends->tail = ways - 1;
+        for (unsigned i = 0; i < ways; i++) {
+            before[i] = i - 1;
+            after[i] = i + 1;
+        }
+    }
+
+    static void hit(unsigned char *meta, unsigned ways, unsigned way){
+        ends_t *ends = (ends_t *)meta;
+        if (ends->head == way) return;
+
+        uint16_t *before = prev(meta);
+        uint16_t *after = next(meta, ways);
+
+        // unlink (the way is not the head, so it has a predecessor)
+        after[before[way]] = after[way];
+        if (ends->tail == way) {
+            ends->tail = before[way];
+        }else{
+            before[after[way]] = before[way];
+        }
+
+        // relink at the head
+        after[way] = ends->head;
+        before[ends->head] = way;
+        ends->head = way;
+    }
+
+    static void insert(unsigned char *meta, unsigned ways, unsigned way){
+        hit(meta, ways, way);
+    }
+
+    static unsigned victim(unsigned char *meta, unsigned){
+        return ((ends_t *)meta)->tail;
+    }
+};
+
+/*
+* tree pseudo-LRU (power-of-two associativity): one bit per inner node of a binary tree over the
+* ways, stored heap-ordered from bit 1; a bit points to the half to replace next; O(log ways)
+*/
+struct plru_policy{
+
+    static unsigned bytes(unsigned){
+        return sizeof(uint64_t);
+    }
+
+    static void reset(unsigned char *meta, unsigned, unsigned long long){
+        *(uint64_t *)meta = 0;
+    }
+
+    static void hit(unsigned char *meta, unsigned ways, unsigned way){
+        uint64_t bits = *(uint64_t *)meta;
+        for (unsigned node = ways + way; node > 1; node >>= 1) {
+            uint64_t parent = 1ULL << (node >> 1);
+            // point away from the accessed child
+            bits = (node & 1) ? (bits & ~parent) : (bits | parent);
+        }
+        *(uint64_t *)meta = bits;
+    }
+
+    static void insert(unsigned char *meta, unsigned ways, unsigned way){
+        hit(meta, ways, way);
+    }
+
+    static unsigned victim(unsigned char *meta, unsigned ways){
+        uint64_t bits = *(uint64_t *)meta;
+        unsigned node = 1;
+        while (node < ways) {
+            node = 2 * node + ((bits >> node) & 1);
+        }
+        return node - ways;
+    }
+};
+
+/*
+* re-reference interval prediction with 2-bit RRPVs, kept as two bit-planes so that finding a way
+* with the distant value and aging the whole set are a few word operations
+* SRRIP inserts at "long" (2), BRRIP at "distant" (3) except once every BRRIP_LONG fills; hits go to 0
+*/
+#define RRPV_DISTANT 3
+#define BRRIP_LONG 32
+
+template <bool BIMODAL>
+struct rrip_policy{
+
+    typedef struct{
+        uint64_t high;
+        uint64_t low;
+        uint32_t seed;
+    } planes_t;
+
+    static uint64_t all(unsigned ways){
+        return (ways >= 64) ? ~0ULL : ((1ULL << ways) - 1);
+    }
+
+    static unsigned bytes(unsigned){
+        return sizeof(planes_t);
+    }
+
+    static void reset(unsigned char *meta, unsigned ways, unsigned long long set){
+        planes_t *rrpv = (planes_t *)meta;
+        rrpv->high = all(ways);
+        rrpv->low = all(ways);
+        rrpv->seed = replacement_seed(set);
+    }
+
+    static void hit(unsigned char *meta, unsigned, unsigned way){
+        planes_t *rrpv = (planes_t *)meta;
+        rrpv->high &= ~(1ULL << way);
+        rrpv->low &= ~(1ULL << way);
+    }
+
+    static void insert(unsigned char *meta, unsigned, unsigned way){
+        planes_t *rrpv = (planes_t *)meta;
+        uint64_t bit = 1ULL << way;
+
+        rrpv->high |= bit;
+        if (BIMODAL && (replacement_random(rrpv->seed) % BRRIP_LONG) != 0) {
+            rrpv->low |= bit;
+        }else{
+            rrpv->low &= ~bit;
+        }
+    }
+
+    static unsigned victim(unsigned char *meta, unsigned ways){
+        planes_t *rrpv = (planes_t *)meta;
+        uint64_t mask = all(ways);
+        uint64_t distant = rrpv->high & rrpv->low & mask;
+
+        if (!distant) {
+            // age every way by the distance between the largest RRPV and RRPV_DISTANT
+            if (rrpv->high) {
+                rrpv->high |= rrpv->low;
+                rrpv->low = ~rrpv->low & mask;
+            }else if (rrpv->low) {
+                rrpv->high = mask;
+            }else{
+                rrpv->high = mask;
+                rrpv->low = mask;
+            }
+            distant = rrpv->high & rrpv->low & mask;
+        }
+        return __builtin_ctzll(distant);
+    }
+};
+
+typedef rrip_policy<false> srrip_policy;
+typedef rrip_policy<true> brrip_policy;
+
+/* random replacement: an independent xorshift sequence per set; O(1) */
+struct random_policy{
+
+    static unsigned bytes(unsigned){
+        return sizeof(uint32_t);
+    }
+
+    static void reset(unsigned char *meta, unsigned, unsigned long long set){
+        *(uint32_t *)meta = replacement_seed(set);
+    }
+
+    static void hit(unsigned char *, unsigned, unsigned){
+    }
+
+    static void insert(unsigned char *, unsigned, unsigned){
+    }
+
+    static unsigned victim(unsigned char *meta, unsigned ways){
+        return (unsigned)(((uint64_t)replacement_random(*(uint32_t *)meta) * ways) >> 32);
+    }
+};
+
+/* runtime dispatch over the policies; the switch is on a per-cache constant, so it predicts perfectly */
+#define REPLACEMENT_DISPATCH(policy, call) \
+    switch (policy) { \
+    case REPLACE_PLRU: return plru_policy::call; \
+    case REPLACE_SRRIP: return srrip_policy::call; \
+    case REPLACE_BRRIP: return brrip_policy::call; \
+    case REPLACE_RANDOM: return random_policy::call; \
+    default: return lru_policy::call; \
+    }
+
+static inline unsigned replacement_bytes(replacement_policy_t policy, unsigned ways){
+    REPLACEMENT_DISPATCH(policy, bytes(ways))
+}
+
+static inline void replacement_reset(replacement_policy_t policy, unsigned char *meta, unsigned ways, unsigned long long set){
+    REPLACEMENT_DISPATCH(policy, reset(meta, ways, set))
+}
+
+static inline void replacement_hit(replacement_policy_t policy, unsigned char *meta, unsigned ways, unsigned way){
+    REPLACEMENT_DISPATCH(policy, hit(meta, ways, way))
+}
+
+static inline void replacement_insert(replacement_policy_t policy, unsigned char *meta, unsigned ways, unsigned way){
+    REPLACEMENT_DISPATCH(policy, insert(meta, ways, way))
+}
+
+static inline unsigned replacement_victim(replacement_policy_t policy, unsigned char *meta, unsigned ways){
+    REPLACEMENT_DISPATCH(policy, victim(meta, ways))
+}
+
+// name of the policy as printed in configurations
+const char *replacement_name(replacement_policy_t policy);
+
+// parses "lru", "plru", "srrip", "brrip" or "random"; returns false for anything else
+bool replacement_parse(const char *name, replacement_policy_t &policy);
+
+#endif /*REPLACEMENT_H_*/
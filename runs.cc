@@ -0,0 +1,85 @@
+#include "runs.h"
+#include <iostream>
+#include <stdlib.h>
+
+using namespace std;
+
+#define START 0x0
+
+run_compressor::run_compressor(unsigned line_size){
+    if (line_size == 0 || (line_size & (line_size - 1)) != 0) {
+        cerr << "run compression needs a power-of-two line size" << endl;
+        exit(EXIT_FAILURE);
+    }
+    shift = __builtin_ctz(line_size);
+    holding = false;
+    accesses = START;
+    records = START;
+}
+
+bool run_compressor::open(const char *filename, trace_mode_t mode){
+    holding = false;
+    return input.open(filename, mode);
+}
+
+bool run_compressor::open(trace_source *source){
+    holding = false;
+    return input.open(source);
+}
+
+void run_compressor::open(const trace_entry_t *entries, size_t count){
+    holding = false;
+    input.open(entries, count);
+}
+
+size_t run_compressor::fill(trace_entry_t *entries, size_t max){
+    size_t n = START;
+
+    while (n < max) {
+        trace_entry_t &record = entries[n];
+        if (holding) {
+            record = pending;
+            holding = false;
+        }else if (input.next(record)) {
+            accesses++;
+        }else{
+            break;
+        }
+
+        // fold the following accesses while they stay on the line, reads before writes (a write-led run takes writes only)
+        address_t line = record.address >> shift;
+        while (input.next(pending)) {
+            accesses++;
+            if ((pending.address >> shift) != line || pending.core != record.core ||
+                (pending.op == TRACE_READ && (record.op == TRACE_WRITE || record.writes != 0)) || trace_accesses(record) == RUN_LIMIT) {
+                holding = true;
+                break;
+            }
+            (pending.op == TRACE_WRITE) ? record.writes++ : record.reads++;
+        }
+        n++;
+    }
+    records += n;
+    return n;
+}
+
+unsigned long long run_compressor::get_accesses(){
+    return accesses;
+}
+
+unsigned long long run_compressor::get_records(){
+    return records;
+}
+
+void compress_runs(const trace_entry_t *entries, size_t count, unsigned line_size, vector<trace_entry_t> &records){
+    run_compressor runs(line_size);
+    runs.open(entries, count);
+
+    size_t n;
+    do {
+        size_t used = records.size();
+        records.resize(used + SOURCE_BATCH);
+        n = runs.fill(records.data() + used, SOURCE_BATCH);
+        records.resize(used + n);
+    } while (n > 0);
+}
@@ -0,0 +1,58 @@
+#ifndef RUNS_H_
+#define RUNS_H_
+
+#include <vector>
+#include "trace.h"
+
+using namespace std;
+
+#define RUN_LIMIT 0x7FFFFFFF //longest run record (in accesses), so that any run() budget can cut it
+
+/*
+* Same-line run compression. Consecutive accesses of one core to one line of "line_size" bytes collapse
+* into one record: the first access (op, address) with the number of reads, then writes, folded after
+* it (trace_entry_t reads/writes). After the first access of a run the line is cached, or, after a write
+* miss without allocation, still missing, in any cache whose lines are at least "line_size" bytes; so
+* the folded accesses all hit (or all miss without allocating) and run() simulates the record with a
+* single lookup and statistics identical to those of the plain accesses. A run led by a write only folds
+* writes, since a read after a non-allocating write miss would miss, and a read after a folded write
+* starts a new run, so that a record cut anywhere (trace_reader::next with a budget) is still exact.
+* Records are simulated whole by cache::run, run_parallel, access_batch and the sampled runs; the
+* hierarchy, multi-core and stack distance simulations replay them one access at a time (at the address
+* of the record, so their lines must be at least "line_size" bytes as well).
+*/
+class run_compressor : public trace_source{
+
+    /* accesses to compress */
+    trace_reader input;
+    unsigned shift;
+
+    /* first access of the next run, already read */
+    trace_entry_t pending;
+    bool holding;
+
+    /* accesses read and records produced */
+    unsigned long long accesses;
+    unsigned long long records;
+
+public:
+
+    // compresses for caches with lines of at least "line_size" (a power of two) bytes
+    run_compressor(unsigned line_size);
+
+    // compresses the plain accesses of a trace file, of a source or of an array (shared, not copied)
+    bool open(const char *filename, trace_mode_t mode=TRACE_MMAP);
+    bool open(trace_source *source);
+    void open(const trace_entry_t *entries, size_t count);
+
+    size_t fill(trace_entry_t *entries, size_t max);
+
+    // accesses read and records produced so far
+    unsigned long long get_accesses();
+    unsigned long long get_records();
+};
+
+// appends to "records" the run records of the "count" plain accesses of "entries"
+void compress_runs(const trace_entry_t *entries, size_t count, unsigned line_size, vector<trace_entry_t> &records);
+
+#endif /*RUNS_H_*/
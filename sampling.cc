@@ -0,0 +1,247 @@
+#include "cache.h"
+#include <math.h>
+
+using namespace std;
+
+#define START 0x0
+#define SAMPLE_CHUNK (1 << 16) //accesses decoded at a time by the sampled runs
+
+void estimate_add(ratio_estimate_t &ratio, double accesses, double misses){
+    ratio.samples++;
+    ratio.accesses += accesses;
+    ratio.misses += misses;
+    ratio.accesses_squared += accesses * accesses;
+    ratio.misses_squared += misses * misses;
+    ratio.product += accesses * misses;
+}
+
+double estimate_ratio(const ratio_estimate_t &ratio){
+    return (ratio.accesses > 0) ? ratio.misses / ratio.accesses : 0;
+}
+
+/* variance of the ratio estimator: fpc * sum((y - R x)^2) / (n - 1) / (n * mean(x)^2) */
+double estimate_bound(const ratio_estimate_t &ratio, double fpc){
+    if (ratio.samples < 2 || ratio.accesses <= 0) return INFINITY;
+
+    double n = ratio.samples;
+    double r = ratio.misses / ratio.accesses;
+    double mean = ratio.accesses / n;
+    double spread = ratio.misses_squared - 2 * r * ratio.product + r * r * ratio.accesses_squared;
+    if (spread < 0) spread = 0;
+    if (fpc < 0) fpc = 0;
+    return SAMPLE_Z * sqrt(fpc * spread / (n - 1) / (n * mean * mean));
+}
+
+// adds "sample" to the read, write and overall estimates; returns its accesses
+static unsigned long long estimate_counters(ratio_estimate_t &reads, ratio_estimate_t &writes, ratio_estimate_t &all, const counters_t &sample){
+    if (sample.reads + sample.writes == 0) return 0;
+    estimate_add(reads, sample.reads, sample.rd_miss);
+    estimate_add(writes, sample.writes, sample.wr_miss);
+    estimate_add(all, (double)sample.reads + sample.writes, (double)sample.rd_miss + sample.wr_miss);
+    return (unsigned long long)sample.reads + sample.writes;
+}
+
+void cache::begin_sampling(sampling_mode_t mode){
+    if (sampling == mode) return;
+    sampling = mode;
+    samples.clear();
+    window_reads = window_writes = window_all = ratio_estimate_t();
+    window_measured = START;
+    sampled_trace = START;
+    sampled_fraction = 0;
+}
+
+void cache::merge_samples(const counters_t &measured, unsigned long long accesses){
+    counters.reads += measured.reads;
+    counters.rd_miss += measured.rd_miss;
+    counters.writes += measured.writes;
+    counters.wr_miss += measured.wr_miss;
+    counters.eviction += measured.eviction;
+    counters.hits += measured.hits;
+    counters.memory += measured.memory;
+    PROFILE_MERGE(counters, measured);
+    number_memory_accesses += accesses;
+}
+
+/*
+* The sampled sets are spread over the index space by a hash of the set number, so that strided
+* access patterns cannot line up with them, and dealt round-robin to SAMPLE_GROUPS clusters.
+* The accesses to sampled sets are gathered in chunks with one list per cluster, in trace order, and
+* every list goes through the sharded engine with the counters of its cluster; sets never interact, so
+* the sampled sets evolve exactly as in a full run. The bounds assume that no single set carries a
+* large share of the accesses: with very skewed traces the few hottest sets decide the miss rate and
+* time sampling is the safer estimate.
+*/
+void cache::run_sampled_sets(unsigned ratio, unsigned num_entries){
+    if (ratio == 0 || sized < 2) {
+        cerr << "set sampling needs a ratio of at least 1 and a cache of several sets" << endl;
+        return;
+    }
+    if (intervals != NULL) {
+        cerr << "set sampling cannot run while an interval log is open" << endl;
+        return;
+    }
+    begin_sampling(SAMPLING_SETS);
+    samples.resize(SAMPLE_GROUPS);
+
+    vector<unsigned char> group(sized, SAMPLE_NONE);
+    unsigned selected = START;
+    for (unsigned j = START; j < sized; j++) {
+        unsigned long long h = (j + 1) * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 31)) * 0xBF58476D1CE4E5B9ULL;
+        if ((h >> 32) % ratio == 0) group[j] = selected++ % SAMPLE_GROUPS;
+    }
+    if (selected == 0) {
+        // tiny caches: fall back on the first set
+        group[0] = 0;
+        selected = 1;
+    }
+    sampled_fraction = (double)selected / sized;
+
+    vector<trace_entry_t> chunk(SAMPLE_CHUNK);
+    vector<unsigned> lists[SAMPLE_GROUPS];
+    unsigned long long taken = START;
+    trace_entry_t entry;
+    bool trace_end = false;
+
+    while (!trace_end && (num_entries == 0 || taken < num_entries)) {
+        // only the accesses to sampled sets are kept
+        size_t n = START;
+        while (n < SAMPLE_CHUNK && (num_entries == 0 || taken < num_entries)) {
+            bool more = (num_entries != 0) ? trace.next(entry, num_entries - taken) : trace.next(entry);
+            if (!more) {
+                trace_end = true;
+                break;
+            }
+            taken += trace_accesses(entry);
+            unsigned char g = group[set_of(entry.address)];
+            if (g == SAMPLE_NONE) continue;
+            lists[g].push_back(n);
+            chunk[n++] = entry;
+        }
+        for (unsigned g = START; g < SAMPLE_GROUPS; g++) {
+            if (lists[g].empty()) continue;
+            counters_t measured = {};
+            (this->*shard_kernel)(chunk.data(), lists[g].data(), lists[g].size(), measured);
+            merge_samples(measured, measured.reads + measured.writes);
+
+            counters_t &cluster = samples[g];
+            cluster.reads += measured.reads;
+            cluster.rd_miss += measured.rd_miss;
+            cluster.writes += measured.writes;
+            cluster.wr_miss += measured.wr_miss;
+            cluster.eviction += measured.eviction;
+            cluster.hits += measured.hits;
+            cluster.memory += measured.memory;
+            lists[g].clear();
+        }
+    }
+    sampled_trace += taken;
+}
+
+/*
+* Time sampling: every period skips "period - warmup - window" accesses (decoded, not simulated), warms
+* the tag array up on "warmup" accesses whose outcome is not counted and measures the next "window"
+* accesses, which make one sample. With warmup = period - window every access updates the tag array
+* (functional warming) and only the counting is sampled. Periods count accesses: run records (runs.h)
+* are cut wherever a stretch ends.
+*/
+void cache::run_sampled_time(unsigned period, unsigned window, unsigned warmup, unsigned num_entries){
+    if (window == 0 || (unsigned long long)warmup + window > period) {
+        cerr << "time sampling needs a window of at least one access and warmup + window <= period" << endl;
+        return;
+    }
+    if (intervals != NULL) {
+        cerr << "time sampling cannot run while an interval log is open" << endl;
+        return;
+    }
+    begin_sampling(SAMPLING_TIME);
+
+    vector<trace_entry_t> chunk(SAMPLE_CHUNK);
+    vector<unsigned> list(SAMPLE_CHUNK);
+    for (unsigned i = START; i < SAMPLE_CHUNK; i++) {
+        list[i] = i;
+    }
+    unsigned long long taken = START;
+    bool trace_end = false;
+
+    // simulates up to "count" accesses charged to "measured"; returns how many the trace had
+    auto simulate = [&](unsigned long long count, counters_t &measured){
+        unsigned long long done = START;
+        trace_entry_t entry;
+        while (done < count && !trace_end) {
+            size_t n = START;
+            while (n < SAMPLE_CHUNK && done < count) {
+                if (!trace.next(entry, count - done)) {
+                    trace_end = true;
+                    break;
+                }
+                chunk[n++] = entry;
+                done += trace_accesses(entry);
+            }
+            if (n > 0) (this->*shard_kernel)(chunk.data(), list.data(), n, measured);
+        }
+        return done;
+    };
+    // what is left of the "num_entries" budget, capped to "count"
+    auto budget = [&](unsigned long long count){
+        if (num_entries == 0) return count;
+        unsigned long long left = num_entries - taken;
+        return (count < left) ? count : left;
+    };
+
+    while (!trace_end && (num_entries == 0 || taken < num_entries)) {
+        unsigned long long gap = budget(period - warmup - window);
+        unsigned long long skipped = trace.pass(gap);
+        taken += skipped;
+        if (skipped < gap) break;
+
+        counters_t discarded = {};
+        taken += simulate(budget(warmup), discarded);
+
+        counters_t measured = {};
+        unsigned long long done = simulate(budget(window), measured);
+        taken += done;
+        if (done == 0) break;
+        merge_samples(measured, done);
+        window_measured += estimate_counters(window_reads, window_writes, window_all, measured);
+    }
+    sampled_trace += taken;
+}
+
+sampling_stats_t cache::get_sampling_statistics(){
+    sampling_stats_t stats = {};
+    ratio_estimate_t reads = {}, writes = {}, all = {};
+
+    stats.mode = sampling;
+    if (sampling == SAMPLING_OFF) return stats;
+
+    unsigned long long measured = START;
+    if (sampling == SAMPLING_SETS) {
+        for (size_t s = START; s < samples.size(); s++) {
+            measured += estimate_counters(reads, writes, all, samples[s]);
+        }
+    }else{
+        reads = window_reads;
+        writes = window_writes;
+        all = window_all;
+        measured = window_measured;
+    }
+
+    stats.trace_accesses = sampled_trace;
+    stats.measured = measured;
+    stats.samples = all.samples;
+    if (sampling == SAMPLING_SETS) stats.fraction = sampled_fraction;
+    else stats.fraction = sampled_trace ? (double)measured / sampled_trace : 0;
+
+    double fpc = 1 - stats.fraction;
+    stats.read_miss_rate = estimate_ratio(reads);
+    stats.read_miss_bound = estimate_bound(reads, fpc);
+    stats.write_miss_rate = estimate_ratio(writes);
+    stats.write_miss_bound = estimate_bound(writes, fpc);
+    stats.miss_rate = estimate_ratio(all);
+    stats.miss_bound = estimate_bound(all, fpc);
+    stats.amat = hitT + penalty * stats.miss_rate;
+    stats.amat_bound = penalty * stats.miss_bound;
+    return stats;
+}
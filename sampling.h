@@ -0,0 +1,56 @@
+#ifndef SAMPLING_H_
+#define SAMPLING_H_
+
+#include <vector>
+
+using namespace std;
+
+/*
+* Sampled simulation (cache::run_sampled_sets, cache::run_sampled_time).
+* Set sampling simulates only a pseudo-random subset of the sets (about one in "ratio"), split into
+* SAMPLE_GROUPS clusters; time sampling simulates periodic windows of the trace, each preceded by an
+* uncounted warm-up, and skips the rest. Either way the miss rates are ratio estimates (misses over
+* accesses of the measured clusters or windows) whose confidence bounds come from the spread between
+* clusters (resp. windows).
+*/
+typedef enum {SAMPLING_OFF, SAMPLING_SETS, SAMPLING_TIME} sampling_mode_t;
+
+#define SAMPLE_GROUPS 32   //clusters of sampled sets behind the set-sampling bounds
+#define SAMPLE_NONE 0xFF   //group of the sets left out of set sampling
+#define SAMPLE_Z 1.96      //normal quantile of the reported bounds (95% confidence)
+
+/* misses over accesses estimated from independent samples (clusters or windows) */
+typedef struct{
+    unsigned long long samples;
+    double accesses;
+    double misses;
+    double accesses_squared;
+    double misses_squared;
+    double product;
+} ratio_estimate_t;
+
+// adds one sample of "accesses" with "misses"
+void estimate_add(ratio_estimate_t &ratio, double accesses, double misses);
+
+// estimated ratio, and the half width of its confidence interval with finite population correction "fpc"
+double estimate_ratio(const ratio_estimate_t &ratio);
+double estimate_bound(const ratio_estimate_t &ratio, double fpc);
+
+/* estimates of a sampled run, as printed by print_statistics */
+typedef struct{
+    sampling_mode_t mode;
+    unsigned long long trace_accesses;   // accesses taken from the trace
+    unsigned long long measured;         // accesses simulated and counted
+    unsigned long long samples;          // clusters of sets or windows
+    double fraction;                     // share of the sets (or of the trace) measured
+    double read_miss_rate;
+    double read_miss_bound;
+    double write_miss_rate;
+    double write_miss_bound;
+    double miss_rate;
+    double miss_bound;
+    double amat;
+    double amat_bound;
+} sampling_stats_t;
+
+#endif /*SAMPLING_H_*/
@@ -0,0 +1,32 @@
+#include "set_index.h"
+#include <string.h>
+
+static const char *names[] = {"modulo", "xor", "skewed"};
+
+const char *index_function_name(index_function_t function){
+    return names[function];
+}
+
+bool index_function_parse(const char *name, index_function_t &function){
+    for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!strcmp(name, names[i])) {
+            function = (index_function_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void set_index_init(set_index_t &index, index_function_t function, unsigned long long sets){
+    index.function = function;
+    index.sets = sets;
+    index.bits = 0;
+    while (index.bits < 64 && (1ULL << index.bits) < sets) {
+        index.bits++;
+    }
+    index.chunk = (index.bits < 64) ? (1ULL << index.bits) - 1 : ~0ULL;
+    bool power = (sets & (sets - 1)) == 0;
+    index.mask = power ? sets - 1 : 0;
+    index.magic = power ? 0 : ~(unsigned __int128)0 / sets + 1;
+    index.direct = power && (function == INDEX_MODULO || sets == 1);
+}
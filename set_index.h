@@ -0,0 +1,63 @@
+#ifndef SET_INDEX_H_
+#define SET_INDEX_H_
+
+#include <stdint.h>
+
+/*
+* Set indexing of the tag array: maps the line address (address >> offset) of an access to its set.
+*   INDEX_MODULO: line modulo the number of sets (the low line bits when it is a power of two)
+*   INDEX_XOR:    the low index-width chunk of the line XORed with the next two chunks, so that lines
+*                 a multiple of the cache size apart spread over the sets
+*   INDEX_SKEWED: the low chunk XORed with the next one rotated by one bit, the skewing function of
+*                 skewed-associative caches (shared by all ways here)
+* The index width is the number of bits of the largest set number; hashed values are reduced to the
+* sets like the line is in INDEX_MODULO. Nothing divides: power-of-two set counts take a mask and the
+* others an exact multiply-shift reduction (Lemire, Kaser and Kurz, "Faster remainder by direct
+* computation", 2019). Only INDEX_MODULO over a power-of-two number of sets leaves the index bits out
+* of the tag (cache.h); every other mapping keeps the whole line address as the tag.
+*/
+typedef enum {INDEX_MODULO, INDEX_XOR, INDEX_SKEWED} index_function_t;
+
+typedef struct{
+    index_function_t function;
+    unsigned long long sets;
+    unsigned long long mask;     // sets - 1 for power-of-two set counts, else 0
+    unsigned bits;               // index width
+    unsigned long long chunk;    // 2^bits - 1
+    unsigned __int128 magic;     // 2^128 / sets, rounded up (other set counts)
+    bool direct;                 // INDEX_MODULO over a power-of-two number of sets (one set included)
+} set_index_t;
+
+// name of "function", as printed ("modulo", "xor", "skewed")
+const char *index_function_name(index_function_t function);
+
+// sets "function" from its name; false when unknown
+bool index_function_parse(const char *name, index_function_t &function);
+
+// prepares "index" for "sets" sets
+void set_index_init(set_index_t &index, index_function_t function, unsigned long long sets);
+
+// "value" modulo the number of sets
+static inline unsigned long long set_index_reduce(const set_index_t &index, unsigned long long value){
+    if (index.mask || index.sets == 1) return value & index.mask;
+    // the fractional part of value / sets, times sets
+    unsigned __int128 fraction = index.magic * value;
+    unsigned __int128 low = (unsigned __int128)(uint64_t)fraction * index.sets;
+    unsigned __int128 high = (fraction >> 64) * index.sets;
+    return (uint64_t)((high + (low >> 64)) >> 64);
+}
+
+// set of the line address "line"
+static inline unsigned long long set_index_of(const set_index_t &index, unsigned long long line){
+    if (index.function == INDEX_XOR) {
+        // two shifts: a single one by 2 * bits is undefined from 32 index bits on
+        unsigned long long next = line >> index.bits;
+        line = (line ^ next ^ (next >> index.bits)) & index.chunk;
+    }else if (index.function == INDEX_SKEWED) {
+        unsigned long long next = (line >> index.bits) & index.chunk;
+        line = (line & index.chunk) ^ ((next >> 1) | (((next & 1) << index.bits) >> 1));
+    }
+    return set_index_reduce(index, line);
+}
+
+#endif /*SET_INDEX_H_*/
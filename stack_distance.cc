@@ -0,0 +1,276 @@
+#include "stack_distance.h"
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+#define START 0x0
+#define NEVER 0xFFFFFFFFFFFFFFFFULL //reuse distance of a line that was never written
+#define COMPACT_SLACK 64 //stale times a set keeps beyond its live lines before it is compacted
+
+stack_distance::stack_distance(unsigned line_size,
+                               unsigned number_sets,
+                               write_policy_t wr_hit_policy,
+                               write_policy_t wr_miss_policy,
+                               unsigned hit_time,
+                               unsigned miss_penalty
+){
+    if (wr_miss_policy != WRITE_ALLOCATE) {
+        cerr << "stack distances require a write-allocate cache" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    if (line_size == 0 || (line_size & (line_size - 1)) != 0 || number_sets == 0) {
+        cerr << "stack distances require a power-of-two line size and at least one set" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    lsize = line_size;
+    sets = number_sets;
+    hit = wr_hit_policy;
+    miss = wr_miss_policy;
+    hitT = hit_time;
+    penalty = miss_penalty;
+
+    offset = __builtin_ctz(line_size);
+    set_index_init(indexing, INDEX_MODULO, number_sets);
+
+    number_memory_accesses = START;
+    cold_reads = START;
+    cold_writes = START;
+
+    stacks.resize(number_sets);
+    for (unsigned i = START; i < number_sets; i++) {
+        stacks[i].tree.push_back(0); // Fenwick trees are 1-based
+        stacks[i].owner.push_back(NULL);
+        stacks[i].distinct = START;
+    }
+}
+
+void stack_distance::load_trace(const char *filename, trace_mode_t mode){
+    if (!trace.open(filename, mode)){
+        cerr << "cannot open trace file " << filename << endl;
+    }
+}
+
+void stack_distance::load_trace(trace_source *source){
+    if (!trace.open(source)){
+        cerr << "cannot allocate the workload buffer" << endl;
+    }
+}
+
+unsigned long long stack_distance::distance(stack_t &stack, unsigned long long last){
+    vector<unsigned> &tree = stack.tree;
+    unsigned long long count = START;
+
+    for (unsigned long long i = tree.size() - 1; i > 0; i &= i - 1) {
+        count += tree[i];
+    }
+    for (unsigned long long i = last; i > 0; i &= i - 1) {
+        count -= tree[i];
+    }
+    return count;
+}
+
+void stack_distance::compact(stack_t &stack){
+    vector<unsigned> &tree = stack.tree;
+    vector<line_t *> &owner = stack.owner;
+    unsigned long long live = 1;
+
+    for (unsigned long long t = 1; t < owner.size(); t++) {
+        if (owner[t]->last != t) continue;
+        owner[live] = owner[t];
+        owner[live]->last = live;
+        live++;
+    }
+    owner.resize(live);
+
+    // every remaining time holds a 1, so each node counts the times it covers
+    tree.resize(live);
+    for (unsigned long long i = 1; i < live; i++) {
+        tree[i] = i & (0 - i);
+    }
+}
+
+void stack_distance::add_writebacks(unsigned long long from, unsigned long long to, long long count){
+    if (from >= to) return;
+    if (writeback_delta.size() < to + 2) {
+        writeback_delta.resize(to + 2, 0);
+    }
+    writeback_delta[from + 1] += count;
+    writeback_delta[to + 1] -= count;
+}
+
+static inline void bump(vector<unsigned long long> &histogram, unsigned long long bucket){
+    if (histogram.size() <= bucket) {
+        histogram.resize(bucket + 1, 0);
+    }
+    histogram[bucket]++;
+}
+
+void stack_distance::access(address_t address, trace_op_t op){
+    long long line = address >> offset;
+    stack_t &stack = stacks[set_index_reduce(indexing, line)];
+    vector<unsigned> &tree = stack.tree;
+
+    pair<unordered_map<long long, line_t>::iterator, bool> found = lines.insert(make_pair(line, line_t()));
+    line_t &record = found.first->second;
+
+    if (found.second) {
+        // cold miss in every cache; it evicts in the caches whose set is already full
+        bump(cold_depth, stack.distinct);
+        stack.distinct++;
+        if (op == TRACE_WRITE) {
+            cold_writes++;
+        }else{
+            cold_reads++;
+        }
+        record.clean = (op == TRACE_WRITE) ? 0 : NEVER;
+    }else{
+        // hit in the caches with more than "d" ways, miss (and re-fetch) in the others
+        unsigned long long d = distance(stack, record.last);
+        bump((op == TRACE_WRITE) ? write_distance : read_distance, d);
+
+        // the line was dirty in the caches with more than "clean" ways and got evicted in those with at most "d"
+        if (hit == WRITE_BACK && record.clean != NEVER) {
+            add_writebacks(record.clean, d, 1);
+        }
+        if (op == TRACE_WRITE) {
+            record.clean = 0;
+        }else if (record.clean != NEVER && d > record.clean) {
+            record.clean = d;
+        }
+
+        for (unsigned long long i = record.last; i < tree.size(); i += i & (0 - i)) {
+            tree[i]--;
+        }
+    }
+
+    // append a 1 at the new time: the node covers (n - lowbit(n), n]
+    unsigned long long n = tree.size();
+    unsigned long long node = 1;
+    for (unsigned long long i = n - 1; i > 0; i &= i - 1) {
+        node += tree[i];
+    }
+    for (unsigned long long i = n & (n - 1); i > 0; i &= i - 1) {
+        node -= tree[i];
+    }
+    tree.push_back(node);
+    stack.owner.push_back(&record);
+    record.last = n;
+
+    if (tree.size() > 2 * stack.distinct + COMPACT_SLACK) {
+        compact(stack);
+    }
+}
+
+void stack_distance::run(unsigned num_entries){
+    unsigned first_access = number_memory_accesses;
+    trace_entry_t entry;
+
+    // run records (runs.h) are cut into single accesses, replayed at the address of the record
+    while (trace.next(entry, 1)) {
+        access(entry.address, entry.op);
+        number_memory_accesses++;
+
+        if ((num_entries != 0) && (number_memory_accesses - first_access) == num_entries) break;
+    }
+}
+
+static inline unsigned long long total(const vector<unsigned long long> &histogram){
+    unsigned long long sum = START;
+    for (size_t i = START; i < histogram.size(); i++) {
+        sum += histogram[i];
+    }
+    return sum;
+}
+
+static inline unsigned long long at(const vector<unsigned long long> &histogram, size_t bucket){
+    return (bucket < histogram.size()) ? histogram[bucket] : 0;
+}
+
+void stack_distance::curve(unsigned max_associativity, vector<point_t> &points){
+    vector<long long> delta = writeback_delta;
+
+    // dirty lines pushed out after their last access are written back as well
+    if (hit == WRITE_BACK) {
+        for (unordered_map<long long, line_t>::iterator it = lines.begin(); it != lines.end(); ++it) {
+            line_t &record = it->second;
+            if (record.clean == NEVER) continue;
+
+            unsigned long long d = distance(stacks[set_index_reduce(indexing, it->first)], record.last);
+            if (record.clean >= d) continue;
+            if (delta.size() < d + 2) {
+                delta.resize(d + 2, 0);
+            }
+            delta[record.clean + 1]++;
+            delta[d + 1]--;
+        }
+    }
+
+    unsigned long long reuse_reads = total(read_distance);
+    unsigned long long reuse_writes = total(write_distance);
+    unsigned long long cold = cold_reads + cold_writes;
+    long long writebacks = START;
+
+    /* misses of the "a"-way cache: cold misses plus the reuses at distance a or more */
+    unsigned long long read_hits = START;
+    unsigned long long write_hits = START;
+    unsigned long long cold_fills = START;
+
+    points.resize(max_associativity);
+    for (unsigned a = 1; a <= max_associativity; a++) {
+        read_hits += at(read_distance, a - 1);
+        write_hits += at(write_distance, a - 1);
+        cold_fills += at(cold_depth, a - 1);
+        if (a < delta.size()) {
+            writebacks += delta[a];
+        }
+
+        point_t &point = points[a - 1];
+        point.reads = cold_reads + reuse_reads;
+        point.writes = cold_writes + reuse_writes;
+        point.rd_miss = cold_reads + reuse_reads - read_hits;
+        point.wr_miss = cold_writes + reuse_writes - write_hits;
+        point.eviction = (reuse_reads - read_hits) + (reuse_writes - write_hits) + (cold - cold_fills);
+        point.memory = (hit == WRITE_BACK) ? writebacks : point.writes;
+    }
+}
+
+float stack_distance::amat(const point_t &point){
+    return float(penalty * ((float(point.rd_miss) + float(point.wr_miss)) / (number_memory_accesses)) + hitT);
+}
+
+void stack_distance::print_statistics(unsigned associativity){
+    if (associativity == 0) return;
+
+    vector<point_t> points;
+    curve(associativity, points);
+    point_t &point = points[associativity - 1];
+
+    cout << "STATISTICS" << endl;
+    cout << "memory accesses = " << dec << number_memory_accesses << endl;
+    cout << "read = " << point.reads << endl;
+    cout << "read misses = " << point.rd_miss << endl;
+    cout << "write = " << point.writes << endl;
+    cout << "write misses = " << point.wr_miss << endl;
+    cout << "evictions = " << point.eviction << endl;
+    cout << "memory writes = " << dec << point.memory << endl;
+    cout << "average memory access time = " << amat(point) << endl;
+}
+
+void stack_distance::print_curve(unsigned max_associativity){
+    vector<point_t> points;
+    curve(max_associativity, points);
+
+    cout << "MISS RATIO CURVE (" << dec << sets << " sets, " << lsize << " B lines)" << endl;
+    cout << setw(7) << "assoc" << setw(12) << "size (B)" << setw(13) << "read misses" << setw(14) << "write misses"
+         << setw(11) << "evictions" << setw(15) << "memory writes" << setw(10) << "AMAT" << endl;
+    for (unsigned a = 1; a <= max_associativity; a++) {
+        point_t &point = points[a - 1];
+        cout << setw(7) << a << setw(12) << (unsigned long long)a * sets * lsize << setw(13) << point.rd_miss
+             << setw(14) << point.wr_miss << setw(11) << point.eviction << setw(15) << point.memory
+             << setw(10) << amat(point) << endl;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef STACK_DISTANCE_H_
+#define STACK_DISTANCE_H_
+
+#include <vector>
+#include <unordered_map>
+#include "cache.h"
+
+using namespace std;
+
+/*
+* Single-pass LRU simulation of every cache capacity (Mattson stack distances).
+* The trace is split into "sets" (a power of two) per-set LRU stacks (1 set = fully-associative), so one run yields the
+* statistics of every "associativity"-way cache with that number of sets and line size, exactly as
+* cache::run would count them. Reuse distances come from a Fenwick tree over each set's access times
+* (O(log n) per access); once most times of a set are stale, its live lines are renumbered 1..distinct
+* and the tree rebuilt, so each tree stays within about twice the lines of its set. Only write-allocate
+* caches are stack algorithms, so no-write-allocate is rejected.
+*/
+class stack_distance{
+
+    /* number of memory accesses processed */
+    unsigned number_memory_accesses;
+
+    /* trace file reader */
+    trace_reader trace;
+
+    /* configuration */
+    unsigned lsize;
+    unsigned sets;
+    write_policy_t hit;
+    write_policy_t miss;
+    unsigned hitT;
+    unsigned penalty;
+
+    unsigned offset;
+    set_index_t indexing;   // line modulo the number of sets
+
+    /* per-line state: last access time in its set, and the reuse distance beyond which the line is clean */
+    typedef struct{
+        unsigned long long last;
+        unsigned long long clean;
+    } line_t;
+
+    /* per-set LRU stack: Fenwick tree with a 1 at the last access time of every line of the set, and
+       the line accessed at every time (stale unless it is the line's last one) */
+    typedef struct{
+        vector<unsigned> tree;
+        vector<line_t *> owner;
+        unsigned long long distinct;
+    } stack_t;
+
+    vector<stack_t> stacks;
+    unordered_map<long long, line_t> lines;
+
+    /* histograms over reuse distance (reads/writes), over stack depth at cold misses, and the
+       difference array of write-backs over associativity */
+    vector<unsigned long long> read_distance;
+    vector<unsigned long long> write_distance;
+    vector<unsigned long long> cold_depth;
+    vector<long long> writeback_delta;
+
+    unsigned long long cold_reads;
+    unsigned long long cold_writes;
+
+    /* totals of one associativity */
+    typedef struct{
+        unsigned long long reads;
+        unsigned long long rd_miss;
+        unsigned long long writes;
+        unsigned long long wr_miss;
+        unsigned long long eviction;
+        unsigned long long memory;
+    } point_t;
+
+    // computes the totals of every associativity from 1 to "max_associativity" (points[0] is 1-way)
+    void curve(unsigned max_associativity, vector<point_t> &points);
+
+    // average memory access time of one point
+    float amat(const point_t &point);
+
+    // records an access of "op" to "address"
+    void access(address_t address, trace_op_t op);
+
+    // number of distinct lines of the set touched after time "last"
+    unsigned long long distance(stack_t &stack, unsigned long long last);
+
+    // renumbers the live times of "stack" 1..distinct, in order, and rebuilds its tree
+    void compact(stack_t &stack);
+
+    // adds "count" write-backs to every associativity in (from, to]
+    void add_writebacks(unsigned long long from, unsigned long long to, long long count);
+
+public:
+
+    /*
+    * Instantiates the stack-distance simulator
+    */
+    stack_distance(unsigned cache_line_size,         // cache block size (in bytes)
+                   unsigned number_sets,             // number of sets (1 = fully-associative)
+                   write_policy_t write_hit_policy,  // write-back or write-through
+                   write_policy_t write_miss_policy, // write-allocate only
+                   unsigned cache_hit_time,          // cache hit time (in clock cycles)
+                   unsigned cache_miss_penalty       // cache miss penalty (in clock cycles)
+    );
+
+    // loads the trace file (with name "filename") so that it can be used by the "run" function
+    void load_trace(const char *filename, trace_mode_t mode=TRACE_MMAP);
+
+    // reads the accesses generated by "source" (e.g. a workload), which must outlive the run
+    void load_trace(trace_source *source);
+
+    // processes "num_memory_accesses" memory accesses from the input trace (all of them when 0)
+    void run(unsigned num_memory_accesses=0);
+
+    // prints the execution statistics of the "associativity"-way cache, in cache::print_statistics format
+    void print_statistics(unsigned associativity);
+
+    // prints one line of statistics per associativity from 1 to "max_associativity"
+    void print_curve(unsigned max_associativity);
+};
+
+#endif /*STACK_DISTANCE_H_*/
@@ -0,0 +1,154 @@
+#include "sweep.h"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <algorithm>
+
+using namespace std;
+
+#define START 0x0
+
+/* per-worker queue of configuration indices: the owner pops from the back, thieves take from the front */
+typedef struct{
+    mutex lock;
+    deque<unsigned> tasks;
+} work_queue_t;
+
+static bool take(work_queue_t &queue, bool steal, unsigned &task){
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty()) return false;
+    if (steal) {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }else{
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    }
+    return true;
+}
+
+bool sweep::load_trace(const char *filename, trace_mode_t mode){
+    trace_reader trace;
+    trace_entry_t entry;
+
+    if (!trace.open(filename, mode)){
+        cerr << "cannot open trace file " << filename << endl;
+        return false;
+    }
+    entries.clear();
+    while (trace.next(entry)) {
+        entries.push_back(entry);
+    }
+    entries.shrink_to_fit();
+    return true;
+}
+
+void sweep::add(const cache_config_t &config){
+    configs.push_back(config);
+}
+
+void sweep::simulate(unsigned i){
+    const cache_config_t &config = configs[i];
+    cache *mycache = new cache(config.size,
+                               config.associativity,
+                               config.line_size,
+                               config.write_hit_policy,
+                               config.write_miss_policy,
+                               config.hit_time,
+                               config.miss_penalty,
+                               config.address_width,
+                               config.replacement,
+                               config.index);
+
+    mycache->load_trace(entries.data(), entries.size());
+    mycache->run();
+    results[i] = mycache->get_statistics();
+    delete mycache;
+}
+
+void sweep::run(unsigned threads){
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    if (threads > configs.size()) {
+        threads = configs.size();
+    }
+
+    results.assign(configs.size(), cache_stats_t());
+    if (configs.empty()) return;
+
+    // deal the configurations round-robin, costliest (most ways) first so that the tail is short
+    vector<unsigned> order(configs.size());
+    for (unsigned i = START; i < order.size(); i++) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [this](unsigned a, unsigned b){
+        return configs[a].associativity > configs[b].associativity;
+    });
+
+    vector<work_queue_t> queues(threads);
+    for (unsigned i = START; i < order.size(); i++) {
+        queues[i % threads].tasks.push_front(order[i]);
+    }
+
+    vector<thread> workers;
+    for (unsigned w = START; w < threads; w++) {
+        workers.push_back(thread([this, w, threads, &queues](){
+            unsigned task;
+            for (;;) {
+                if (take(queues[w], false, task)) {
+                    simulate(task);
+                    continue;
+                }
+                bool stolen = false;
+                for (unsigned k = 1; k < threads && !stolen; k++) {
+                    stolen = take(queues[(w + k) % threads], true, task);
+                }
+                if (!stolen) return;
+                simulate(task);
+            }
+        }));
+    }
+    for (unsigned w = START; w < threads; w++) {
+        workers[w].join();
+    }
+}
+
+static const char *policy_name(const cache_config_t &config){
+    if (config.write_hit_policy == WRITE_BACK) {
+        return (config.write_miss_policy == WRITE_ALLOCATE) ? "WB/WA" : "WB/NWA";
+    }
+    return (config.write_miss_policy == WRITE_ALLOCATE) ? "WT/WA" : "WT/NWA";
+}
+
+void sweep::print_results(ostream &out){
+    out << setw(10) << "size (KB)" << setw(7) << "assoc" << setw(6) << "line" << setw(8) << "policy"
+        << setw(8) << "replace" << setw(8) << "index" << setw(12) << "accesses" << setw(13) << "read misses" << setw(14) << "write misses"
+        << setw(11) << "evictions" << setw(15) << "memory writes" << setw(10) << "AMAT" << endl;
+    for (unsigned i = START; i < configs.size() && i < results.size(); i++) {
+        const cache_config_t &config = configs[i];
+        const cache_stats_t &stats = results[i];
+        out << setw(10) << dec << config.size / 1024 << setw(7) << config.associativity << setw(6) << config.line_size
+            << setw(8) << policy_name(config) << setw(8) << replacement_name(config.replacement)
+            << setw(8) << index_function_name(config.index) << setw(12) << stats.accesses << setw(13) << stats.rd_miss
+            << setw(14) << stats.wr_miss << setw(11) << stats.eviction << setw(15) << stats.memory
+            << setw(10) << stats.amat << endl;
+    }
+}
+
+void sweep::print_csv(ostream &out){
+    out << "size,associativity,line_size,policy,replacement,index,accesses,reads,read_misses,writes,write_misses,evictions,memory_writes,amat" << endl;
+    for (unsigned i = START; i < configs.size() && i < results.size(); i++) {
+        const cache_config_t &config = configs[i];
+        const cache_stats_t &stats = results[i];
+        out << dec << config.size << ',' << config.associativity << ',' << config.line_size << ',' << policy_name(config) << ',' << replacement_name(config.replacement)
+            << ',' << index_function_name(config.index)
+            << ',' << stats.accesses << ',' << stats.reads << ',' << stats.rd_miss << ',' << stats.writes
+            << ',' << stats.wr_miss << ',' << stats.eviction << ',' << stats.memory << ',' << stats.amat << endl;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <vector>
+#include <ostream>
+#include "cache.h"
+
+using namespace std;
+
+/* one point of a design-space sweep (cache constructor arguments) */
+typedef struct{
+    unsigned size;
+    unsigned associativity;
+    unsigned line_size;
+    write_policy_t write_hit_policy;
+    write_policy_t write_miss_policy;
+    unsigned hit_time;
+    unsigned miss_penalty;
+    unsigned address_width;
+    replacement_policy_t replacement;
+    index_function_t index;
+} cache_config_t;
+
+/*
+* Design-space sweep: the trace is decoded once into memory shared read-only by every configuration,
+* and the configurations are simulated by independent caches on a pool of worker threads.
+* Each worker owns a queue of configurations and steals from the others once its own is empty.
+*/
+class sweep{
+
+    /* decoded trace */
+    vector<trace_entry_t> entries;
+
+    /* configurations and their statistics (same order) */
+    vector<cache_config_t> configs;
+    vector<cache_stats_t> results;
+
+    // simulates configuration "i" to completion
+    void simulate(unsigned i);
+
+public:
+
+    // decodes the whole trace file (with name "filename") into memory
+    bool load_trace(const char *filename, trace_mode_t mode=TRACE_MMAP);
+
+    // adds a configuration to the sweep
+    void add(const cache_config_t &config);
+
+    // simulates every configuration on "threads" worker threads (0 = one per hardware thread)
+    void run(unsigned threads=0);
+
+    // prints one line of statistics per configuration
+    void print_results(ostream &out);
+
+    // writes the same table as comma-separated values
+    void print_csv(ostream &out);
+};
+
+#endif /*SWEEP_H_*/
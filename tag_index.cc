@@ -0,0 +1,92 @@
+#include "tag_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace std;
+
+#define START 0x0
+
+tag_index::tag_index(unsigned way_count, const long long *tag_array){
+    unsigned bits = 1;
+    while ((1ULL << bits) < 2ULL * way_count) {
+        bits++;
+    }
+
+    tags = tag_array;
+    ways = way_count;
+    table_mask = (1ULL << bits) - 1;
+    table_shift = 64 - bits;
+    table = (uint32_t *)calloc(table_mask + 1, sizeof(uint32_t));
+    prev = (uint32_t *)malloc(ways * sizeof(uint32_t));
+    next = (uint32_t *)malloc(ways * sizeof(uint32_t));
+    free_ways = (uint32_t *)malloc(ways * sizeof(uint32_t));
+    if (table == NULL || prev == NULL || next == NULL || free_ways == NULL) {
+        cerr << "cannot allocate the tag index of " << ways << " ways" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    head = NO_WAY;
+    tail = NO_WAY;
+    free_count = START;
+    for (unsigned i = ways; i > START; i--) {
+        free_ways[free_count++] = i - 1;
+    }
+}
+
+tag_index::~tag_index(){
+    free(table);
+    free(prev);
+    free(next);
+    free(free_ways);
+}
+
+void tag_index::unhash(uint32_t way){
+    uint64_t hole = home(tags[way]);
+    while (table[hole] != way + 1) {
+        hole = (hole + 1) & table_mask;
+    }
+
+    // pull back every following entry of the run whose home is not between the hole and itself
+    for (uint64_t i = (hole + 1) & table_mask; table[i] != 0; i = (i + 1) & table_mask) {
+        uint64_t start = home(tags[table[i] - 1]);
+        if (((i - start) & table_mask) >= ((i - hole) & table_mask)) {
+            table[hole] = table[i];
+            hole = i;
+        }
+    }
+    table[hole] = 0;
+}
+
+size_t tag_index::state_bytes(){
+    return (3 + (table_mask + 1) + 3 * (size_t)ways) * sizeof(uint32_t);
+}
+
+void tag_index::save(unsigned char *out){
+    uint32_t header[3] = {head, tail, free_count};
+    memcpy(out, header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, table, (table_mask + 1) * sizeof(uint32_t));
+    out += (table_mask + 1) * sizeof(uint32_t);
+    memcpy(out, prev, ways * sizeof(uint32_t));
+    out += ways * sizeof(uint32_t);
+    memcpy(out, next, ways * sizeof(uint32_t));
+    out += ways * sizeof(uint32_t);
+    memcpy(out, free_ways, ways * sizeof(uint32_t));
+}
+
+void tag_index::load(const unsigned char *in){
+    uint32_t header[3];
+    memcpy(header, in, sizeof(header));
+    head = header[0];
+    tail = header[1];
+    free_count = header[2];
+    in += sizeof(header);
+    memcpy(table, in, (table_mask + 1) * sizeof(uint32_t));
+    in += (table_mask + 1) * sizeof(uint32_t);
+    memcpy(prev, in, ways * sizeof(uint32_t));
+    in += ways * sizeof(uint32_t);
+    memcpy(next, in, ways * sizeof(uint32_t));
+    in += ways * sizeof(uint32_t);
+    memcpy(free_ways, in, ways * sizeof(uint32_t));
+}
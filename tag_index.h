@@ -0,0 +1,118 @@
+#ifndef TAG_INDEX_H_
+#define TAG_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+* Lookup structure of fully-associative caches: an open-addressing hash table from tag to way and an
+* intrusive LRU list threaded through the ways, so hits, misses and evictions are O(1) whatever the
+* number of ways. The tags themselves stay in the cache's tag array; the table stores way numbers.
+* Only valid ways are hashed and listed; invalid ways wait on a free stack (lowest way on top).
+*/
+
+#define NO_WAY 0xFFFFFFFFu
+
+class tag_index{
+
+    /* hash table: way + 1 per bucket (0 = empty), linear probing */
+    uint32_t *table;
+    uint64_t table_mask;
+    unsigned table_shift;
+
+    /* tags of the ways (owned by the cache) */
+    const long long *tags;
+    unsigned ways;
+
+    /* recency list, most recent at the head */
+    uint32_t *prev;
+    uint32_t *next;
+    uint32_t head;
+    uint32_t tail;
+
+    /* invalid ways */
+    uint32_t *free_ways;
+    unsigned free_count;
+
+    uint64_t home(long long tag){
+        return ((uint64_t)tag * 0x9E3779B97F4A7C15ULL) >> table_shift;
+    }
+
+    void unlink(uint32_t way){
+        if (prev[way] != NO_WAY) next[prev[way]] = next[way]; else head = next[way];
+        if (next[way] != NO_WAY) prev[next[way]] = prev[way]; else tail = prev[way];
+    }
+
+    void link(uint32_t way){
+        prev[way] = NO_WAY;
+        next[way] = head;
+        if (head != NO_WAY) prev[head] = way; else tail = way;
+        head = way;
+    }
+
+    // removes the bucket of "way" (backward-shift deletion keeps probe chains unbroken)
+    void unhash(uint32_t way);
+
+    // tag indexes are bound to one tag array and are not copied
+    tag_index(const tag_index &);
+    tag_index &operator=(const tag_index &);
+
+public:
+
+    // indexes the "ways" tags of "tag_array"; all ways start invalid
+    tag_index(unsigned ways, const long long *tag_array);
+
+    ~tag_index();
+
+    // returns the valid way holding "tag", or -1
+    int find(long long tag){
+        for (uint64_t i = home(tag);; i = (i + 1) & table_mask) {
+            uint32_t bucket = table[i];
+            if (bucket == 0) return -1;
+            if (tags[bucket - 1] == tag) return bucket - 1;
+        }
+    }
+
+    // marks "way" as most recently used
+    void touch(uint32_t way){
+        if (head == way) return;
+        unlink(way);
+        link(way);
+    }
+
+    // least recently used valid way (NO_WAY when the cache is empty)
+    uint32_t lru(){
+        return tail;
+    }
+
+    // takes an invalid way, or returns NO_WAY when every way is valid
+    uint32_t claim(){
+        return free_count ? free_ways[--free_count] : NO_WAY;
+    }
+
+    // "way" now holds a valid tag: hashes it and makes it the most recently used
+    void insert(uint32_t way){
+        uint64_t i = home(tags[way]);
+        while (table[i] != 0) {
+            i = (i + 1) & table_mask;
+        }
+        table[i] = way + 1;
+        link(way);
+    }
+
+    // size of the state copied by save/load (hash table, recency list and free stack)
+    size_t state_bytes();
+
+    // copies the state to "out", or restores it from "in" as saved by an index of as many ways
+    void save(unsigned char *out);
+    void load(const unsigned char *in);
+
+    // drops the valid "way" (before its tag is overwritten); "release" returns it to the free stack
+    void remove(uint32_t way, bool release){
+        unhash(way);
+        unlink(way);
+        if (release) free_ways[free_count++] = way;
+    }
+};
+
+#endif /*TAG_INDEX_H_*/
@@ -0,0 +1,99 @@
+#include "tag_match.h"
+#include "cache.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
+
+#define START 0x0
+
+static int match_scalar(const long long *tags, const unsigned char *state, unsigned ways, long long tag){
+    for (unsigned i = START; i < ways; i++) {
+        if ((state[i] & BLOCK_VALID) && (tags[i] == tag)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef HAVE_X86_SIMD
+
+/* a tag can match several ways when stale tags are left in invalid ways, so every candidate is checked */
+static inline int first_valid(unsigned mask, unsigned base, const unsigned char *state){
+    while (mask) {
+        unsigned way = base + __builtin_ctz(mask);
+        if (state[way] & BLOCK_VALID) {
+            return way;
+        }
+        mask &= mask - 1;
+    }
+    return -1;
+}
+
+__attribute__((target("sse4.1")))
+static int match_sse(const long long *tags, const unsigned char *state, unsigned ways, long long tag){
+    __m128i key = _mm_set1_epi64x(tag);
+    unsigned i = START;
+
+    for (; i + 2 <= ways; i += 2) {
+        __m128i cmp = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i *)(tags + i)), key);
+        unsigned mask = _mm_movemask_pd(_mm_castsi128_pd(cmp));
+        if (mask) {
+            int way = first_valid(mask, i, state);
+            if (way >= 0) return way;
+        }
+    }
+    for (; i < ways; i++) {
+        if ((state[i] & BLOCK_VALID) && (tags[i] == tag)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static int match_avx2(const long long *tags, const unsigned char *state, unsigned ways, long long tag){
+    __m256i key = _mm256_set1_epi64x(tag);
+    unsigned i = START;
+
+    for (; i + 8 <= ways; i += 8) {
+        __m256i lo = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(tags + i)), key);
+        __m256i hi = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(tags + i + 4)), key);
+        unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo)) | (_mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4);
+        if (mask) {
+            int way = first_valid(mask, i, state);
+            if (way >= 0) return way;
+        }
+    }
+    for (; i + 4 <= ways; i += 4) {
+        __m256i cmp = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(tags + i)), key);
+        unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+        if (mask) {
+            int way = first_valid(mask, i, state);
+            if (way >= 0) return way;
+        }
+    }
+    for (; i < ways; i++) {
+        if ((state[i] & BLOCK_VALID) && (tags[i] == tag)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#endif /*HAVE_X86_SIMD*/
+
+tag_match_t select_tag_match(unsigned ways, match_isa_t isa){
+#ifdef HAVE_X86_SIMD
+    if (isa == MATCH_AUTO) {
+        // below 4 ways a vector compare does not pay for itself
+        if (ways < 4) return match_scalar;
+        if (__builtin_cpu_supports("avx2")) return match_avx2;
+        if (__builtin_cpu_supports("sse4.1")) return match_sse;
+        return match_scalar;
+    }
+    if (isa == MATCH_AVX2 && __builtin_cpu_supports("avx2")) return match_avx2;
+    if (isa == MATCH_SSE && __builtin_cpu_supports("sse4.1")) return match_sse;
+#endif
+    return match_scalar;
+}
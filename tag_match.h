@@ -0,0 +1,12 @@
+#ifndef TAG_MATCH_H_
+#define TAG_MATCH_H_
+
+typedef enum {MATCH_AUTO, MATCH_SCALAR, MATCH_SSE, MATCH_AVX2} match_isa_t;
+
+// returns the valid way of a set holding "tag", or -1 when the set does not hold it
+typedef int (*tag_match_t)(const long long *tags, const unsigned char *state, unsigned ways, long long tag);
+
+// picks the way-parallel matcher for sets of "ways" ways; MATCH_AUTO uses the widest one the host supports
+tag_match_t select_tag_match(unsigned ways, match_isa_t isa=MATCH_AUTO);
+
+#endif /*TAG_MATCH_H_*/
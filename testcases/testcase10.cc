@@ -0,0 +1,96 @@
+#include "cache.h"
+#include "workload.h"
+#include "runs.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for checkpoints: a warmed-up cache saved, restored into a fresh one and run to the end, */
+/* then the same with a run-compressed trace whose checkpoint falls inside a run record */
+
+int main(int argc, char **argv){
+
+	const char *state = "/tmp/testcase10.state";
+	replacement_policy_t policies[] = {REPLACE_LRU, REPLACE_SRRIP, REPLACE_RANDOM};
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 256*KB, 64, 0, 20000, 0.3, 0.9, 10};
+
+	for (unsigned p=0; p<sizeof(policies)/sizeof(policies[0]); p++){
+
+		// reference: the whole stream in one run
+		workload generator(config);
+		cache *reference = new cache(8*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32, policies[p]);
+		reference->load_trace(&generator);
+		reference->run();
+
+		// warm-up on the first half, saved
+		generator.reset();
+		cache *warm = new cache(8*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32, policies[p]);
+		warm->load_trace(&generator);
+		warm->run(10000);
+		warm->save_state(state);
+
+		// restored: the stream resumes at the checkpoint
+		generator.reset();
+		cache *restored = new cache(8*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32, policies[p]);
+		restored->load_state(state);
+		restored->load_trace(&generator);
+		restored->print_configuration();
+		restored->run();
+		restored->print_statistics();
+		restored->print_tag_array();
+
+		cache_stats_t a = reference->get_statistics();
+		cache_stats_t b = restored->get_statistics();
+		cout << "checkpoint " << ((a.accesses == b.accesses && a.rd_miss == b.rd_miss && a.wr_miss == b.wr_miss &&
+					  a.eviction == b.eviction && a.memory == b.memory) ? "identical" : "different") << endl << endl;
+
+		delete restored;
+		delete warm;
+		delete reference;
+	}
+
+	// sequential 8-byte accesses: eight per line, so every record folds several accesses
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t sequential = {WORKLOAD_SEQUENTIAL, 0x20000000, 64*KB, 8, 0, 50001, 0.3, 0, 11};
+	workload stream(sequential);
+	trace_entry_t batch[SOURCE_BATCH];
+	vector<trace_entry_t> plain, records;
+	for (size_t n; (n = stream.fill(batch, SOURCE_BATCH)) > 0; ) {
+		plain.insert(plain.end(), batch, batch + n);
+	}
+	compress_runs(plain.data(), plain.size(), 64, records);
+
+	cache *reference = new cache(8*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32);
+	reference->load_trace(plain.data(), plain.size());
+	reference->run();
+
+	cache *warm = new cache(8*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32);
+	warm->load_trace(records.data(), records.size());
+	warm->run(20003);
+	warm->save_state(state);
+
+	cache *restored = new cache(8*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32);
+	restored->load_state(state);
+	restored->load_trace(records.data(), records.size());
+	restored->run();
+	restored->print_statistics();
+
+	cache_stats_t a = reference->get_statistics();
+	cache_stats_t b = restored->get_statistics();
+	cout << "cut record checkpoint " << ((a.accesses == b.accesses && a.reads == b.reads && a.writes == b.writes &&
+				       a.rd_miss == b.rd_miss && a.wr_miss == b.wr_miss && a.eviction == b.eviction &&
+				       a.memory == b.memory) ? "identical" : "different") << endl;
+
+	delete restored;
+	delete warm;
+	delete reference;
+
+	remove(state);
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include "multicore.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the MESI multi-core system: private and shared lines over four cores, serial and parallel */
+
+int main(int argc, char **argv){
+
+	vector<trace_entry_t> trace;
+	unsigned long long seed = 11;
+
+	// a quarter of the accesses go to lines shared by every core, the rest to lines private to each core
+	for (unsigned i=0; i<200000; i++){
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		unsigned core = seed % 4;
+		bool shared = ((seed >> 8) % 4) == 0;
+		address_t address = shared ? 0x100000 + ((seed >> 16) % 128) * 64 : 0x200000 + core * 0x10000 + ((seed >> 16) % 256) * 64;
+		trace_entry_t entry = {address, ((seed >> 40) % 3 == 0) ? TRACE_WRITE : TRACE_READ, core};
+		trace.push_back(entry);
+	}
+
+	multicore *serial = new multicore(4,		//cores
+					  8*KB,		//private cache size
+					  4,		//associativity
+					  64,		//cache line size
+					  2,		//hit time
+					  100,		//miss penalty
+					  32		//address width
+					  );
+	serial->print_configuration();
+	cout << endl;
+	serial->load_trace(trace.data(), trace.size());
+	serial->run();
+	serial->print_statistics();
+	cout << endl;
+
+	multicore *parallel = new multicore(4, 8*KB, 4, 64, 2, 100, 32);
+	parallel->load_trace(trace.data(), trace.size());
+	parallel->run_parallel(4);
+
+	bool same = true;
+	for (unsigned c=0; c<4; c++){
+		core_stats_t a = serial->get_core_statistics(c);
+		core_stats_t b = parallel->get_core_statistics(c);
+		same = same && !memcmp(&a, &b, sizeof(core_stats_t));
+	}
+	cout << "parallel run " << (same ? "identical" : "different") << endl;
+
+	delete parallel;
+	delete serial;
+	return 0;
+}
@@ -0,0 +1,49 @@
+#include "cache.h"
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+#define MB (1024*1024)
+
+using namespace std;
+
+/* Test case for the sparse tag array: a 1 GB cache touched in a handful of far apart sets */
+
+int main(int argc, char **argv){
+
+	cache *mycache = new cache(1024*MB,		//size
+				   8,			//associativity
+				   64,			//cache line size
+				   WRITE_BACK,		//write hit policy
+				   WRITE_ALLOCATE,	//write miss policy
+				   5,			//hit time
+				   100,			//miss penalty
+				   48			//address width
+				   );
+	mycache->print_configuration();
+	cout << endl;
+	cout << "populated sets = " << mycache->populated_sets() << endl;
+
+	// nine lines of one set (one eviction), then lines spread over the index space
+	vector<trace_entry_t> trace;
+	for (unsigned i=0; i<9; i++){
+		trace_entry_t entry = {(address_t)0x12340040 + (address_t)i * 0x8000000, TRACE_WRITE, 0};
+		trace.push_back(entry);
+	}
+	for (unsigned i=0; i<32; i++){
+		trace_entry_t entry = {(address_t)i * 0x4F0C40, TRACE_READ, 0};
+		trace.push_back(entry);
+	}
+	trace_entry_t again = {(address_t)0x12340040 + 0x8000000, TRACE_READ, 0};
+	trace.push_back(again);
+	mycache->access_batch(trace.data(), trace.size());
+
+	cout << "populated sets = " << mycache->populated_sets() << endl;
+	cout << endl;
+	mycache->print_statistics();
+	cout << endl;
+	mycache->print_tag_array();
+
+	delete mycache;
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include "cache.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the structured dumps: CSV and JSON lines of the tag array and statistics after traces/simple.t, */
+/* then the binary statistics record read back */
+
+static void show(const char *filename){
+	ifstream in(filename);
+	cout << in.rdbuf();
+	remove(filename);
+}
+
+int main(int argc, char **argv){
+
+	cache *mycache = new cache(1*KB,		//size
+				  2,			//associativity
+				  64,			//cache line size
+				  WRITE_BACK,		//write hit policy
+				  WRITE_ALLOCATE,	//write miss policy
+				  5,			//hit time
+				  100,			//miss penalty
+				  32			//address width
+				  );
+	mycache->load_trace("traces/simple.t");
+	mycache->run();
+
+	const char *tags = "/tmp/testcase13.tags";
+	const char *stats = "/tmp/testcase13.stats";
+
+	cout << "CSV" << endl;
+	mycache->export_tag_array(tags, EXPORT_CSV);
+	show(tags);
+	mycache->export_statistics(stats, EXPORT_CSV);
+	show(stats);
+
+	cout << endl << "JSON LINES" << endl;
+	mycache->export_tag_array(tags, EXPORT_JSONL);
+	show(tags);
+	mycache->export_statistics(stats, EXPORT_JSONL);
+	show(stats);
+
+	cout << endl << "BINARY" << endl;
+	mycache->export_statistics(stats, EXPORT_BINARY);
+	ifstream in(stats, ios::binary);
+	export_header_t header;
+	export_stats_t record;
+	in.read((char *)&header, sizeof(header));
+	in.read((char *)&record, sizeof(record));
+	in.close();
+	remove(stats);
+	cout << string(header.magic, 4) << " version " << header.version << " record " << header.record << " bytes" << endl;
+	cout << record.accesses << "," << record.reads << "," << record.rd_miss << "," << record.writes << "," << record.wr_miss << ","
+	     << record.eviction << "," << record.memory << "," << record.amat << " reserved " << record.reserved << endl;
+
+	cout << endl;
+	mycache->print_tag_array();
+
+	delete mycache;
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "cache.h"
+#include "runs.h"
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for same-line run compression: the records of traces/simple.t for 64-byte lines, then the
+   statistics of the plain and compressed traces (the latter run 5 accesses at a time), which must match */
+
+static cache *make_cache(){
+	return new cache(1*KB,		//size
+			 2,			//associativity
+			 64,			//cache line size
+			 WRITE_THROUGH,		//write hit policy
+			 NO_WRITE_ALLOCATE,	//write miss policy
+			 5,			//hit time
+			 100,			//miss penalty
+			 32			//address width
+			 );
+}
+
+int main(int argc, char **argv){
+
+	trace_reader reader;
+	vector<trace_entry_t> plain;
+	trace_entry_t entry;
+	reader.open("traces/simple.t");
+	while (reader.next(entry)) plain.push_back(entry);
+
+	vector<trace_entry_t> records;
+	compress_runs(plain.data(), plain.size(), 64, records);
+	cout << "RECORDS" << endl;
+	for (size_t i = 0; i < records.size(); i++) {
+		cout << ((records[i].op == TRACE_WRITE) ? "w " : "r ") << hex << records[i].address << dec
+		     << " +" << records[i].reads << "r +" << records[i].writes << "w" << endl;
+	}
+
+	cout << endl << "PLAIN" << endl;
+	cache *mycache = make_cache();
+	mycache->load_trace(plain.data(), plain.size());
+	mycache->run();
+	mycache->print_statistics();
+	mycache->print_tag_array();
+	delete mycache;
+
+	cout << endl << "COMPRESSED" << endl;
+	mycache = make_cache();
+	mycache->load_trace(records.data(), records.size());
+	for (unsigned step = 0; step < 3; step++) {
+		mycache->run(5);
+	}
+	mycache->print_statistics();
+	mycache->print_tag_array();
+	delete mycache;
+
+	return 0;
+}
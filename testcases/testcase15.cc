@@ -0,0 +1,40 @@
+#include "cache.h"
+#include <iostream>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for set indexing: a 3 KB 4-way cache of 12 sets (modulo, XOR and skewed mappings) and a 16-set XOR-indexed one, on traces/simple.t */
+
+static void simulate(unsigned size, index_function_t index_function){
+	cache *mycache = new cache(size,		//size
+				  4,			//associativity
+				  64,			//cache line size
+				  WRITE_BACK,		//write hit policy
+				  WRITE_ALLOCATE,	//write miss policy
+				  5,			//hit time
+				  100,			//miss penalty
+				  32,			//address width
+				  REPLACE_LRU,		//replacement policy
+				  index_function	//set indexing
+				  );
+	mycache->load_trace("traces/simple.t");
+	mycache->run();
+	mycache->print_configuration();
+	mycache->print_statistics();
+	mycache->print_tag_array();
+	cout << dec << endl;
+	delete mycache;
+}
+
+int main(int argc, char **argv){
+
+	simulate(3*KB, INDEX_MODULO);
+	simulate(3*KB, INDEX_XOR);
+	simulate(3*KB, INDEX_SKEWED);
+	simulate(4*KB, INDEX_XOR);
+
+	return 0;
+}
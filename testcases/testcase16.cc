@@ -0,0 +1,83 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the sampled runs: sampling every set, or every access of every period, must reproduce
+   the statistics of the full run; then the estimates of real set and time samples (uniform accesses,
+   since very skewed traces defeat set sampling) */
+
+static cache *make_cache(){
+	return new cache(16*KB,		//size
+			 4,			//associativity
+			 64,			//cache line size
+			 WRITE_BACK,		//write hit policy
+			 WRITE_ALLOCATE,	//write miss policy
+			 5,			//hit time
+			 100,			//miss penalty
+			 32			//address width
+			 );
+}
+
+static bool same(cache *a, cache *b){
+	cache_stats_t x = a->get_statistics();
+	cache_stats_t y = b->get_statistics();
+	return x.accesses == y.accesses && x.reads == y.reads && x.rd_miss == y.rd_miss && x.writes == y.writes &&
+	       x.wr_miss == y.wr_miss && x.eviction == y.eviction && x.memory == y.memory;
+}
+
+int main(int argc, char **argv){
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_UNIFORM, 0x10000000, 48*KB, 64, 0, 200000, 0.3, 0, 16};
+	workload generator(config);
+
+	cache *full = make_cache();
+	full->load_trace(&generator);
+	full->run();
+	cout << "FULL RUN" << endl;
+	full->print_statistics();
+
+	// every set sampled
+	generator.reset();
+	cache *sets = make_cache();
+	sets->load_trace(&generator);
+	sets->run_sampled_sets(1);
+	cout << endl << "run_sampled_sets(1) " << (same(full, sets) ? "identical" : "different") << endl;
+
+	// every access of every period measured, in several calls
+	generator.reset();
+	cache *time = make_cache();
+	time->load_trace(&generator);
+	time->run_sampled_time(1000, 1000, 0, 50000);
+	time->run_sampled_time(1000, 1000, 0);
+	cout << "run_sampled_time(1000, 1000, 0) " << (same(full, time) ? "identical" : "different") << endl;
+
+	// one set in 8
+	generator.reset();
+	cache *sampled = make_cache();
+	sampled->load_trace(&generator);
+	sampled->run_sampled_sets(8);
+	cout << endl << "SAMPLED SETS (1 in 8)" << endl;
+	sampled->print_statistics();
+	delete sampled;
+
+	// 1000-access windows every 10000 accesses, after 2000 accesses of warmup
+	generator.reset();
+	sampled = make_cache();
+	sampled->load_trace(&generator);
+	sampled->run_sampled_time(10000, 1000, 2000);
+	cout << endl << "SAMPLED TIME (1000 of 10000, warmup 2000)" << endl;
+	sampled->print_statistics();
+	delete sampled;
+
+	delete time;
+	delete sets;
+	delete full;
+
+	return 0;
+}
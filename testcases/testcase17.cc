@@ -0,0 +1,108 @@
+#include "cache.h"
+#include "workload.h"
+#include "pipeline.h"
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the decoding pipeline: a text trace of several PIPELINE_BLOCK blocks (and its binary
+   copy) decoded by trace_pipeline with one to four decoders, then simulated under TRACE_PIPELINE in
+   run(N) steps; everything must match the TRACE_MMAP decoding */
+
+static cache *make_cache(){
+	return new cache(16*KB,		//size
+			 4,			//associativity
+			 64,			//cache line size
+			 WRITE_BACK,		//write hit policy
+			 WRITE_ALLOCATE,	//write miss policy
+			 5,			//hit time
+			 100,			//miss penalty
+			 32			//address width
+			 );
+}
+
+static bool same(cache *a, cache *b){
+	cache_stats_t x = a->get_statistics();
+	cache_stats_t y = b->get_statistics();
+	return x.accesses == y.accesses && x.reads == y.reads && x.rd_miss == y.rd_miss && x.writes == y.writes &&
+	       x.wr_miss == y.wr_miss && x.eviction == y.eviction && x.memory == y.memory;
+}
+
+int main(int argc, char **argv){
+
+	const char *text = "/tmp/testcase17.t";
+	const char *binary = "/tmp/testcase17.bin";
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 1024*KB, 8, 0, 400000, 0.3, 0.9, 17};
+	workload generator(config);
+
+	// the trace, in text and binary
+	vector<trace_entry_t> entries;
+	trace_entry_t entry;
+	trace_reader source;
+	source.open(&generator);
+	while (source.next(entry)) entries.push_back(entry);
+
+	FILE *out = fopen(text, "w");
+	trace_writer writer;
+	writer.open(binary);
+	for (size_t i = 0; i < entries.size(); i++) {
+		fprintf(out, "%c 0x%llx\n", (entries[i].op == TRACE_WRITE) ? 'w' : 'r', (unsigned long long)entries[i].address);
+		writer.write(entries[i]);
+	}
+	fclose(out);
+	writer.close();
+
+	ifstream in(text, ios::binary | ios::ate);
+	unsigned long long size = in.tellg();
+	cout << "text trace: " << entries.size() << " accesses in " << (size + PIPELINE_BLOCK - 1) / PIPELINE_BLOCK << " blocks" << endl;
+
+	// the decoders hand the accesses out in trace order
+	const char *files[] = {text, binary};
+	for (unsigned f = 0; f < 2; f++) {
+		for (unsigned threads = 1; threads <= 4; threads++) {
+			trace_pipeline pipeline;
+			pipeline.open(files[f], threads);
+			const trace_entry_t *chunk;
+			size_t count;
+			size_t decoded = 0;
+			bool match = true;
+			while (pipeline.next(chunk, count)) {
+				for (size_t i = 0; i < count; i++, decoded++) {
+					if (decoded >= entries.size() || chunk[i].op != entries[decoded].op || chunk[i].address != entries[decoded].address) match = false;
+				}
+			}
+			cout << ((f == 0) ? "text" : "binary") << " pipeline, " << threads << " decoders: " << decoded << " accesses "
+			     << ((match && decoded == entries.size()) ? "identical" : "different") << endl;
+		}
+	}
+
+	// simulation under TRACE_PIPELINE, resumed across run(N) calls
+	cache *reference = make_cache();
+	reference->load_trace(text, TRACE_MMAP);
+	reference->run();
+	cout << endl;
+	reference->print_statistics();
+
+	for (unsigned f = 0; f < 2; f++) {
+		cache *pipelined = make_cache();
+		pipelined->load_trace(files[f], TRACE_PIPELINE);
+		pipelined->run(150001);
+		pipelined->run(100000);
+		pipelined->run();
+		cout << ((f == 0) ? "text" : "binary") << " TRACE_PIPELINE run " << (same(reference, pipelined) ? "identical" : "different") << endl;
+		delete pipelined;
+	}
+
+	delete reference;
+	remove(text);
+	remove(binary);
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for compressed traces: traces/simple.t and a synthetic trace gzipped at test time (in one
+   member, in two members split mid-line, and as a gzipped binary trace) run in every trace mode, the
+   TRACE_PIPELINE one falling back on the sequential decoder; the statistics must match the plain files */
+
+static cache *make_cache(){
+	return new cache(16*KB,		//size
+			 4,			//associativity
+			 64,			//cache line size
+			 WRITE_BACK,		//write hit policy
+			 WRITE_ALLOCATE,	//write miss policy
+			 5,			//hit time
+			 100,			//miss penalty
+			 32			//address width
+			 );
+}
+
+static bool same(cache *a, cache *b){
+	cache_stats_t x = a->get_statistics();
+	cache_stats_t y = b->get_statistics();
+	return x.accesses == y.accesses && x.reads == y.reads && x.rd_miss == y.rd_miss && x.writes == y.writes &&
+	       x.wr_miss == y.wr_miss && x.eviction == y.eviction && x.memory == y.memory;
+}
+
+#ifdef HAVE_ZLIB
+// gzips "from" into "to", in one member or in "members" members of about equal size
+static void gzip_file(const char *from, const char *to, unsigned members){
+	FILE *in = fopen(from, "rb");
+	string data;
+	char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) data.append(buffer, n);
+	fclose(in);
+
+	remove(to);
+	for (unsigned m = 0; m < members; m++) {
+		size_t start = data.size() * m / members;
+		size_t end = data.size() * (m + 1) / members;
+		gzFile out = gzopen(to, "ab");
+		gzwrite(out, data.data() + start, end - start);
+		gzclose(out);
+	}
+}
+#endif
+
+int main(int argc, char **argv){
+
+#ifdef HAVE_ZLIB
+	const char *text = "/tmp/testcase18.t";
+	const char *binary = "/tmp/testcase18.bin";
+	const char *simple = "/tmp/testcase18-simple.t.gz";
+	const char *gzipped = "/tmp/testcase18.t.gz";
+	const char *members = "/tmp/testcase18-members.t.gz";
+	const char *gzipped_binary = "/tmp/testcase18.bin.gz";
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 1024*KB, 8, 0, 200000, 0.3, 0.9, 18};
+	workload generator(config);
+	trace_reader source;
+	trace_entry_t entry;
+	source.open(&generator);
+	FILE *out = fopen(text, "w");
+	trace_writer writer;
+	writer.open(binary);
+	while (source.next(entry)) {
+		fprintf(out, "%c 0x%llx\n", (entry.op == TRACE_WRITE) ? 'w' : 'r', (unsigned long long)entry.address);
+		writer.write(entry);
+	}
+	fclose(out);
+	writer.close();
+
+	gzip_file("traces/simple.t", simple, 1);
+	gzip_file(text, gzipped, 1);
+	gzip_file(text, members, 2);
+	gzip_file(binary, gzipped_binary, 1);
+
+	const char *plain[] = {"traces/simple.t", text, text, binary};
+	const char *compressed[] = {simple, gzipped, members, gzipped_binary};
+	const char *names[] = {"simple.t.gz", "gzip text", "gzip text, 2 members", "gzip binary"};
+	trace_mode_t modes[] = {TRACE_MMAP, TRACE_STREAM, TRACE_PIPELINE};
+	const char *mode_names[] = {"TRACE_MMAP", "TRACE_STREAM", "TRACE_PIPELINE"};
+
+	for (unsigned f = 0; f < sizeof(compressed)/sizeof(compressed[0]); f++) {
+		cache *reference = make_cache();
+		reference->load_trace(plain[f]);
+		reference->run();
+		cout << names[f] << ": " << reference->get_statistics().accesses << " accesses" << endl;
+
+		for (unsigned m = 0; m < sizeof(modes)/sizeof(modes[0]); m++) {
+			cache *mycache = make_cache();
+			mycache->load_trace(compressed[f], modes[m]);
+			mycache->run(5);
+			mycache->run();
+			cout << "  " << mode_names[m] << " " << (same(reference, mycache) ? "identical" : "different") << endl;
+			delete mycache;
+		}
+		delete reference;
+	}
+
+	remove(text);
+	remove(binary);
+	remove(simple);
+	remove(gzipped);
+	remove(members);
+	remove(gzipped_binary);
+#else
+	cout << "gzip support not compiled in" << endl;
+#endif
+
+	return 0;
+}
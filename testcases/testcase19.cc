@@ -0,0 +1,51 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the replacement policies: 4-way and 8-way caches of two sets under every policy, on a */
+/* small skewed workload; the tag array after each phase pins the order in which the ways are victimized */
+
+int main(int argc, char **argv){
+
+	replacement_policy_t policies[] = {REPLACE_LRU, REPLACE_PLRU, REPLACE_SRRIP, REPLACE_BRRIP, REPLACE_RANDOM};
+	unsigned ways[] = {4, 8};
+
+	for (unsigned p=0; p<sizeof(policies)/sizeof(policies[0]); p++){
+		for (unsigned w=0; w<sizeof(ways)/sizeof(ways[0]); w++){
+
+			//pattern		base		footprint	stride	element	count	writes	zipf	seed
+			workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 2*KB, 64, 0, 150, 0.3, 0.8, 19};
+			workload generator(config);
+
+			cache *mycache = new cache(2*ways[w]*64,		//size
+						   ways[w],		//associativity
+						   64,			//cache line size
+						   WRITE_BACK,		//write hit policy
+						   WRITE_ALLOCATE, 	//write miss policy
+						   5, 			//hit time
+						   100, 		//miss penalty
+						   32,    		//address width
+						   policies[p]		//replacement policy
+						   );
+
+			cout << "POLICY " << replacement_name(policies[p]) << ", " << ways[w] << "-way" << endl;
+			mycache->load_trace(&generator);
+			for (unsigned phase=0; phase<3; phase++){
+				mycache->run(50);
+				mycache->print_tag_array();
+				cout << dec;
+			}
+			mycache->print_statistics();
+			cout << endl;
+
+			delete mycache;
+		}
+	}
+
+	return 0;
+}
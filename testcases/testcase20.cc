@@ -0,0 +1,87 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the set-sharded parallel run: traces/simple.t and a synthetic workload simulated by */
+/* run_parallel on 1 to 8 threads (in run(N) steps), whose statistics and tag array must match the serial run */
+
+static cache *make_cache(write_policy_t hit, write_policy_t miss){
+	return new cache(4*KB,		//size
+			 2,			//associativity
+			 64,			//cache line size
+			 hit,			//write hit policy
+			 miss,			//write miss policy
+			 5,			//hit time
+			 100,			//miss penalty
+			 32			//address width
+			 );
+}
+
+// statistics and tag array, as printed
+static string dump(cache *mycache){
+	stringstream out;
+	streambuf *console = cout.rdbuf(out.rdbuf());
+	mycache->print_statistics();
+	mycache->print_tag_array();
+	cout << dec;
+	cout.rdbuf(console);
+	return out.str();
+}
+
+int main(int argc, char **argv){
+
+	write_policy_t hits[] = {WRITE_BACK, WRITE_THROUGH};
+	write_policy_t misses[] = {WRITE_ALLOCATE, NO_WRITE_ALLOCATE};
+	unsigned threads[] = {1, 2, 3, 8};
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 64*KB, 8, 0, 100000, 0.3, 0.9, 20};
+
+	for (unsigned p=0; p<2; p++){
+		cout << "POLICY " << ((p == 0) ? "write-back, write-allocate" : "write-through, no-write-allocate") << endl;
+
+		// traces/simple.t
+		cache *serial = make_cache(hits[p], misses[p]);
+		serial->load_trace("traces/simple.t");
+		serial->run();
+		string reference = dump(serial);
+		cout << reference;
+		delete serial;
+
+		for (unsigned t=0; t<sizeof(threads)/sizeof(threads[0]); t++){
+			cache *parallel = make_cache(hits[p], misses[p]);
+			parallel->load_trace("traces/simple.t");
+			parallel->run_parallel(threads[t]);
+			cout << "simple.t, " << threads[t] << " threads " << ((dump(parallel) == reference) ? "identical" : "different") << endl;
+			delete parallel;
+		}
+
+		// workload, run in steps
+		workload generator(config);
+		serial = make_cache(hits[p], misses[p]);
+		serial->load_trace(&generator);
+		serial->run();
+		reference = dump(serial);
+		delete serial;
+
+		for (unsigned t=0; t<sizeof(threads)/sizeof(threads[0]); t++){
+			generator.reset();
+			cache *parallel = make_cache(hits[p], misses[p]);
+			parallel->load_trace(&generator);
+			parallel->run_parallel(threads[t], 30000);
+			parallel->run_parallel(threads[t], 12345);
+			parallel->run_parallel(threads[t]);
+			cout << "workload, " << threads[t] << " threads " << ((dump(parallel) == reference) ? "identical" : "different") << endl;
+			delete parallel;
+		}
+		cout << endl;
+	}
+
+	return 0;
+}
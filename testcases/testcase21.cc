@@ -0,0 +1,63 @@
+#include "cache.h"
+#include "workload.h"
+#include "stack_distance.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for fully-associative caches: traces/simple.t in a 16-way single-set cache (associativity 0), */
+/* then a 512-way one on a synthetic workload, checked against the single-set stack-distance simulation */
+
+int main(int argc, char **argv){
+
+	cache *mycache = new cache(1*KB,		//size
+				  0,			//associativity (fully-associative)
+				  64,			//cache line size
+				  WRITE_BACK,		//write hit policy
+				  WRITE_ALLOCATE,	//write miss policy
+				  5,			//hit time
+				  100,			//miss penalty
+				  32			//address width
+				  );
+	mycache->print_configuration();
+	mycache->load_trace("traces/simple.t");
+	for (unsigned step=0; step<3; step++){
+		mycache->run(4);
+		mycache->print_tag_array();
+		cout << dec;
+	}
+	mycache->print_statistics();
+	cout << endl;
+	delete mycache;
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 256*KB, 64, 0, 100000, 0.3, 0.9, 21};
+	workload generator(config);
+
+	// associativity = size / line size is fully-associative as well
+	mycache = new cache(32*KB, 512, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32);
+	mycache->load_trace(&generator);
+	mycache->run();
+	cout << "FULLY-ASSOCIATIVE, 512 WAYS" << endl;
+	mycache->print_statistics();
+
+	generator.reset();
+	stack_distance stacks(64, 1, WRITE_BACK, WRITE_ALLOCATE, 5, 100);
+	stacks.load_trace(&generator);
+	stacks.run();
+
+	stringstream a, b;
+	streambuf *console = cout.rdbuf(a.rdbuf());
+	mycache->print_statistics();
+	cout.rdbuf(b.rdbuf());
+	stacks.print_statistics(512);
+	cout.rdbuf(console);
+	cout << "stack distances " << ((a.str() == b.str()) ? "identical" : "different") << endl;
+
+	delete mycache;
+	return 0;
+}
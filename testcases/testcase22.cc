@@ -0,0 +1,86 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for interval statistics: the CSV series of traces/simple.t every 5 accesses (run one access */
+/* at a time, so the last interval is partial), then the binary series of a workload run in uneven steps */
+/* and in parallel, whose last snapshot must match the final statistics */
+
+static cache *make_cache(){
+	return new cache(1*KB,		//size
+			 2,			//associativity
+			 64,			//cache line size
+			 WRITE_BACK,		//write hit policy
+			 WRITE_ALLOCATE,	//write miss policy
+			 5,			//hit time
+			 100,			//miss penalty
+			 32			//address width
+			 );
+}
+
+int main(int argc, char **argv){
+
+	const char *csv = "/tmp/testcase22.csv";
+	const char *binary = "/tmp/testcase22.bin";
+
+	cache *mycache = make_cache();
+	mycache->load_trace("traces/simple.t");
+	mycache->set_interval_log(5, csv);
+	for (unsigned i=0; i<12; i++){
+		mycache->run(1);
+	}
+	mycache->close_interval_log();
+	mycache->print_statistics();
+
+	cout << "CSV" << endl;
+	ifstream text(csv);
+	cout << text.rdbuf();
+	text.close();
+	remove(csv);
+	delete mycache;
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 64*KB, 8, 0, 50000, 0.3, 0.9, 22};
+	workload generator(config);
+
+	mycache = make_cache();
+	mycache->load_trace(&generator);
+	mycache->set_interval_log(4096, binary, INTERVAL_BINARY);
+	mycache->run(10000);
+	mycache->run_parallel(2, 7777);
+	mycache->run();
+	mycache->close_interval_log();
+
+	ifstream in(binary, ios::binary);
+	char header[INTERVAL_HEADER];
+	in.read(header, INTERVAL_HEADER);
+	cout << endl << "BINARY" << endl << string(header, 4) << " version " << (int)header[4] << endl;
+
+	interval_t snapshot;
+	unsigned count = 0;
+	bool regular = true;
+	while (in.read((char *)&snapshot, sizeof(snapshot))) {
+		if (snapshot.accesses != (unsigned long long)(count + 1) * 4096 && snapshot.accesses != 50000) regular = false;
+		count++;
+	}
+	in.close();
+	remove(binary);
+
+	cache_stats_t stats = mycache->get_statistics();
+	cout << count << " snapshots, every 4096 accesses " << (regular ? "yes" : "no") << endl;
+	cout << "last: " << snapshot.accesses << "," << snapshot.reads << "," << snapshot.rd_miss << "," << snapshot.writes << ","
+	     << snapshot.wr_miss << "," << snapshot.eviction << "," << snapshot.memory << endl;
+	cout << "final statistics " << ((snapshot.accesses == stats.accesses && snapshot.reads == stats.reads && snapshot.rd_miss == stats.rd_miss &&
+					 snapshot.writes == stats.writes && snapshot.wr_miss == stats.wr_miss && snapshot.eviction == stats.eviction &&
+					 snapshot.memory == stats.memory) ? "identical" : "different") << endl;
+
+	delete mycache;
+	return 0;
+}
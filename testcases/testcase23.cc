@@ -0,0 +1,97 @@
+#include "sweep.h"
+#include "workload.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for configuration sweeps: a sweep of a synthetic trace on 1 and 4 threads, each point checked */
+/* against its own cache, then the sweep tool on traces/simple.t (run from the repository root) */
+
+int main(int argc, char **argv){
+
+	const char *text = "/tmp/testcase23.t";
+	const char *csv = "/tmp/testcase23.csv";
+	const char *table = "/tmp/testcase23.txt";
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 64*KB, 8, 0, 20000, 0.3, 0.9, 23};
+	workload generator(config);
+	trace_reader source;
+	trace_entry_t entry;
+	source.open(&generator);
+	FILE *out = fopen(text, "w");
+	while (source.next(entry)) {
+		fprintf(out, "%c 0x%llx\n", (entry.op == TRACE_WRITE) ? 'w' : 'r', (unsigned long long)entry.address);
+	}
+	fclose(out);
+
+	vector<cache_config_t> points;
+	unsigned sizes[] = {1*KB, 4*KB};
+	unsigned ways[] = {1, 4, 0};
+	write_policy_t hits[] = {WRITE_BACK, WRITE_THROUGH};
+	replacement_policy_t policies[] = {REPLACE_LRU, REPLACE_SRRIP};
+	for (unsigned s=0; s<2; s++)
+		for (unsigned a=0; a<3; a++)
+			for (unsigned h=0; h<2; h++)
+				for (unsigned r=0; r<2; r++) {
+					if (ways[a] == 0 && policies[r] != REPLACE_LRU) continue; // fully-associative caches are LRU
+					cache_config_t point = {sizes[s], ways[a], 64, hits[h], (hits[h] == WRITE_BACK) ? WRITE_ALLOCATE : NO_WRITE_ALLOCATE,
+								5, 100, 32, policies[r], INDEX_MODULO};
+					points.push_back(point);
+				}
+
+	string tables[2];
+	vector<string> rows;
+	unsigned threads[] = {1, 4};
+	for (unsigned t=0; t<2; t++) {
+		sweep mysweep;
+		mysweep.load_trace(text);
+		for (unsigned i=0; i<points.size(); i++) mysweep.add(points[i]);
+		mysweep.run(threads[t]);
+		stringstream results, csv_rows;
+		mysweep.print_results(results);
+		mysweep.print_csv(csv_rows);
+		tables[t] = results.str() + csv_rows.str();
+		string row;
+		getline(csv_rows, row); // header
+		while (t == 0 && getline(csv_rows, row)) rows.push_back(row);
+	}
+	cout << tables[0];
+	cout << "4 threads " << ((tables[0] == tables[1]) ? "identical" : "different") << endl;
+
+	// every point as its own cache: same counters as its row
+	unsigned matching = 0;
+	for (unsigned i=0; i<points.size() && i<rows.size(); i++) {
+		cache_config_t &c = points[i];
+		cache mycache(c.size, c.associativity, c.line_size, c.write_hit_policy, c.write_miss_policy, c.hit_time, c.miss_penalty,
+			      c.address_width, c.replacement, c.index);
+		mycache.load_trace(text);
+		mycache.run();
+		cache_stats_t stats = mycache.get_statistics();
+		stringstream counters;
+		counters << ',' << stats.accesses << ',' << stats.reads << ',' << stats.rd_miss << ',' << stats.writes
+			 << ',' << stats.wr_miss << ',' << stats.eviction << ',' << stats.memory << ',' << stats.amat;
+		string expected = counters.str();
+		if (rows[i].size() >= expected.size() && rows[i].compare(rows[i].size() - expected.size(), expected.size(), expected) == 0) matching++;
+	}
+	cout << matching << " of " << points.size() << " points identical to their own cache" << endl;
+	remove(text);
+
+	// the tool
+	int status = system("bin/sweep -s 1,4 -a 1,2 -l 64 -p wb -j 2 -c /tmp/testcase23.csv traces/simple.t > /tmp/testcase23.txt");
+	cout << endl << "TOOL (exit status " << status << ")" << endl;
+	ifstream tool(table);
+	cout << tool.rdbuf();
+	ifstream results(csv);
+	cout << results.rdbuf();
+	remove(table);
+	remove(csv);
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <stdlib.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the way-parallel tag matchers: each forced ISA (falling back on the scalar loop where the */
+/* host lacks it) against a reference loop on random sets of 1 to 33 ways, invalid ways holding the tag */
+/* included, then whole cache runs whose statistics must not depend on the matcher */
+
+int main(int argc, char **argv){
+
+	match_isa_t isas[] = {MATCH_AUTO, MATCH_SCALAR, MATCH_SSE, MATCH_AVX2};
+	const char *names[] = {"auto", "scalar", "sse", "avx2"};
+	unsigned ways[] = {1, 2, 3, 4, 5, 7, 8, 9, 12, 16, 17, 32, 33};
+
+	long long tags[64];
+	unsigned char state[64];
+	unsigned long long seed = 24;
+
+	for (unsigned w=0; w<sizeof(ways)/sizeof(ways[0]); w++){
+		unsigned n = ways[w];
+		cout << n << " ways:";
+		for (unsigned m=0; m<sizeof(isas)/sizeof(isas[0]); m++){
+			tag_match_t match = select_tag_match(n, isas[m]);
+			unsigned wrong = 0;
+			for (unsigned trial=0; trial<2000; trial++){
+				// distinct tags (some negative, some sharing their low 32 bits), about one way in four invalid
+				for (unsigned i=0; i<n; i++){
+					seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+					tags[i] = (long long)((seed >> 40) << 8 | i) * ((seed & 1) ? -1 : 1) + (((seed >> 3) & 1) ? (1LL << 32) : 0);
+					state[i] = ((seed >> 20) & 3) ? BLOCK_VALID | ((seed >> 5) & BLOCK_DIRTY) : 0;
+				}
+				long long tag = tags[(seed >> 33) % n];
+				if ((seed >> 50) % 4 == 0) tag ^= 1LL << 32;
+				int expected = -1;
+				for (unsigned i=0; i<n; i++){
+					if ((state[i] & BLOCK_VALID) && tags[i] == tag) {
+						expected = i;
+						break;
+					}
+				}
+				if (match(tags, state, n, tag) != expected) wrong++;
+			}
+			cout << " " << names[m] << ((wrong == 0) ? " ok" : " WRONG");
+		}
+		cout << endl;
+	}
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_ZIPF, 0x10000000, 256*KB, 64, 0, 50000, 0.3, 0.9, 24};
+	unsigned associativities[] = {2, 8, 16};
+	for (unsigned a=0; a<sizeof(associativities)/sizeof(associativities[0]); a++){
+		cache_stats_t reference = {};
+		for (unsigned m=0; m<sizeof(isas)/sizeof(isas[0]); m++){
+			workload generator(config);
+			cache *mycache = new cache(16*KB, associativities[a], 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32);
+			mycache->set_tag_match(isas[m]);
+			mycache->load_trace(&generator);
+			mycache->run();
+			cache_stats_t stats = mycache->get_statistics();
+			if (m == 0) {
+				reference = stats;
+				cout << endl << associativities[a] << "-WAY" << endl;
+				mycache->print_statistics();
+			}else{
+				cout << names[m] << " " << ((stats.rd_miss == reference.rd_miss && stats.wr_miss == reference.wr_miss &&
+							    stats.eviction == reference.eviction && stats.memory == reference.memory) ? "identical" : "different") << endl;
+			}
+			delete mycache;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "cache.h"
+#include "stack_distance.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the stack-distance simulator: every associativity from one pass, */
+/* checked against one cache simulation per associativity */
+
+int main(int argc, char **argv){
+
+	//WRITE-BACK, WRITE-ALLOCATE, 16 sets of 256 B lines
+
+	stack_distance *curve = new stack_distance(256,		//cache line size
+						   16,			//number of sets
+						   WRITE_BACK,		//write hit policy
+						   WRITE_ALLOCATE, 	//write miss policy
+						   5, 			//hit time
+						   100 			//miss penalty
+						   );
+
+	curve->load_trace("traces/simple.t");
+	curve->run();
+	curve->print_curve(4);
+	cout << endl;
+
+	for (unsigned n=1; n<=4; n=n*2){
+
+		cout << "ASSOCIATIVITY = " << dec << n << endl;
+		cout << "===================" << endl << endl;
+
+		cout << "stack distance" << endl;
+		curve->print_statistics(n);
+		cout << endl;
+
+		cache *mycache = new cache(16*256*n,		//size
+					   n,			//associativity
+					   256,			//cache line size
+					   WRITE_BACK,		//write hit policy
+					   WRITE_ALLOCATE, 	//write miss policy
+					   5, 			//hit time
+					   100, 		//miss penalty
+					   32    		//address width
+					   );
+
+		mycache->load_trace("traces/simple.t");
+		mycache->run();
+
+		cout << "cache" << endl;
+		mycache->print_statistics();
+		cout << endl;
+
+		delete mycache;
+	}
+
+	delete curve;
+}
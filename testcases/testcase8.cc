@@ -0,0 +1,66 @@
+#include "hierarchy.h"
+#include "workload.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the multi-level hierarchy: two levels under each inclusion policy, then an exclusive */
+/* hierarchy on reads only, whose clean victims move down without counting as write-backs */
+
+int main(int argc, char **argv){
+
+	inclusion_policy_t policies[] = {INCLUSIVE, EXCLUSIVE, NON_INCLUSIVE};
+
+	for (unsigned p=0; p<3; p++){
+
+		hierarchy *myhierarchy = new hierarchy(policies[p]);
+
+		myhierarchy->add_level(new cache(256,			//size
+						 1,			//associativity
+						 64,			//cache line size
+						 WRITE_BACK,		//write hit policy
+						 WRITE_ALLOCATE, 	//write miss policy
+						 2, 			//hit time
+						 0, 			//miss penalty
+						 32    		//address width
+						 ));
+
+		myhierarchy->add_level(new cache(1*KB,			//size
+						 2,			//associativity
+						 64,			//cache line size
+						 WRITE_BACK,		//write hit policy
+						 WRITE_ALLOCATE, 	//write miss policy
+						 10, 			//hit time
+						 100, 			//miss penalty
+						 32    		//address width
+						 ));
+
+		myhierarchy->print_configuration();
+		cout << endl;
+
+		myhierarchy->load_trace("traces/simple.t");
+		myhierarchy->run();
+
+		myhierarchy->print_statistics();
+		cout << endl;
+
+		delete myhierarchy;
+	}
+
+	//pattern		base		footprint	stride	element	count	writes	zipf	seed
+	workload_config_t config = {WORKLOAD_UNIFORM, 0x10000000, 4*KB, 64, 0, 1000, 0.0, 0, 8};
+	workload generator(config);
+
+	hierarchy *exclusive = new hierarchy(EXCLUSIVE);
+	exclusive->add_level(new cache(256, 1, 64, WRITE_BACK, WRITE_ALLOCATE, 2, 0, 32));
+	exclusive->add_level(new cache(1*KB, 2, 64, WRITE_BACK, WRITE_ALLOCATE, 10, 100, 32));
+	exclusive->load_trace(&generator);
+	exclusive->run();
+	cout << "EXCLUSIVE, READS ONLY" << endl;
+	exclusive->print_statistics();
+	delete exclusive;
+}
@@ -0,0 +1,62 @@
+#include "cache.h"
+#include "workload.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+#define KB 1024
+
+using namespace std;
+
+/* Test case for the synthetic workload generators: each pattern streamed straight into the cache */
+
+int main(int argc, char **argv){
+
+	const char *names[] = {"sequential", "strided", "uniform", "zipf", "pointer-chase"};
+
+	workload_config_t workloads[] = {
+		//pattern		base		footprint	stride	element	count	writes	zipf	seed
+		{WORKLOAD_SEQUENTIAL,	0x10000000,	8*KB,		64,	0,	10000,	0.0,	0,	1},
+		{WORKLOAD_SEQUENTIAL,	0x10000000,	32*KB,		64,	0,	10000,	0.25,	0,	2},
+		{WORKLOAD_STRIDED,	0x10000000,	64*KB,		4*KB,	64,	10000,	0.0,	0,	3},
+		{WORKLOAD_UNIFORM,	0x10000000,	32*KB,		8,	0,	10000,	0.3,	0,	4},
+		{WORKLOAD_ZIPF,		0x10000000,	1024*KB,	64,	0,	10000,	0.3,	0.99,	5},
+		{WORKLOAD_ZIPF,		0x10000000,	1024*KB,	64,	0,	10000,	0.3,	1.2,	6},
+		{WORKLOAD_POINTER_CHASE,0x10000000,	16*KB,		64,	0,	10000,	0.5,	0,	7}
+	};
+	unsigned patterns[] = {0, 0, 1, 2, 3, 3, 4};
+
+	for (unsigned w=0; w<sizeof(workloads)/sizeof(workloads[0]); w++){
+
+		cache *mycache = new cache(16*KB,		//size
+					   4,			//associativity
+					   64,			//cache line size
+					   WRITE_BACK,		//write hit policy
+					   WRITE_ALLOCATE, 	//write miss policy
+					   5, 			//hit time
+					   100, 		//miss penalty
+					   32    		//address width
+					   );
+
+		workload generator(workloads[w]);
+
+		cout << "WORKLOAD " << names[patterns[w]] << " footprint = " << workloads[w].footprint/KB << " KB" << endl;
+		mycache->load_trace(&generator);
+		mycache->run();
+		mycache->print_statistics();
+		cout << endl;
+
+		// the same seed gives the same stream
+		generator.reset();
+		cache *replay = new cache(16*KB, 4, 64, WRITE_BACK, WRITE_ALLOCATE, 5, 100, 32);
+		replay->load_trace(&generator);
+		replay->run();
+		cout << "replay " << ((replay->get_statistics().rd_miss == mycache->get_statistics().rd_miss &&
+				       replay->get_statistics().memory == mycache->get_statistics().memory) ? "identical" : "different") << endl << endl;
+
+		delete replay;
+		delete mycache;
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "sweep.h"
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <string.h>
+
+#define KB 1024
+
+using namespace std;
+
+/* Sweeps every combination of the given cache sizes, associativities, line sizes, write and replacement */
+/* policies and set indexing over one trace, e.g. "sweep -s 16,32,48 -a 1,2,4,8,12 -l 32,64 -p wb,wt -r lru,srrip -x modulo,xor -j 8 traces/GCC.t" */
+
+static void usage(const char *name){
+    cerr << "usage: " << name << " [-s sizes (KB)] [-a associativities] [-l line sizes] [-p wb,wt]" << endl
+         << "       [-r lru,plru,srrip,brrip,random] [-x modulo,xor,skewed] [-w address width] [-j threads]" << endl
+         << "       [-c results.csv] <trace>" << endl;
+    exit(1);
+}
+
+static vector<unsigned> parse_list(const char *arg){
+    vector<unsigned> values;
+    char *end;
+    for (const char *p = arg; *p; p = (*end == ',') ? end + 1 : end) {
+        values.push_back(strtoul(p, &end, 10));
+        if (end == p) break;
+    }
+    return values;
+}
+
+static vector<replacement_policy_t> parse_replacements(const char *arg, const char *name){
+    vector<replacement_policy_t> values;
+    string list(arg);
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+        replacement_policy_t policy;
+        if (!replacement_parse(list.substr(begin, end - begin).c_str(), policy)) usage(name);
+        values.push_back(policy);
+        begin = end + 1;
+    }
+    return values;
+}
+
+static vector<index_function_t> parse_indexing(const char *arg, const char *name){
+    vector<index_function_t> values;
+    string list(arg);
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) end = list.size();
+        index_function_t function;
+        if (!index_function_parse(list.substr(begin, end - begin).c_str(), function)) usage(name);
+        values.push_back(function);
+        begin = end + 1;
+    }
+    return values;
+}
+
+int main(int argc, char **argv){
+
+    vector<unsigned> sizes = parse_list("16,32,64");
+    vector<unsigned> associativities = parse_list("1,2,4,8,16");
+    vector<unsigned> lines = parse_list("64");
+    vector<replacement_policy_t> replacements(1, REPLACE_LRU);
+    vector<index_function_t> indexing(1, INDEX_MODULO);
+    bool write_back = true;
+    bool write_through = true;
+    unsigned width = 48;
+    unsigned threads = 0;
+    const char *csv = NULL;
+    int i;
+
+    for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+        const char *value = argv[i+1];
+        switch (argv[i][1]) {
+            case 's': sizes = parse_list(value); break;
+            case 'a': associativities = parse_list(value); break;
+            case 'l': lines = parse_list(value); break;
+            case 'p': write_back = strstr(value, "wb") != NULL; write_through = strstr(value, "wt") != NULL; break;
+            case 'r': replacements = parse_replacements(value, argv[0]); break;
+            case 'x': indexing = parse_indexing(value, argv[0]); break;
+            case 'w': width = strtoul(value, NULL, 10); break;
+            case 'j': threads = strtoul(value, NULL, 10); break;
+            case 'c': csv = value; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (i != argc - 1) usage(argv[0]);
+
+    sweep design;
+    if (!design.load_trace(argv[i])) return 1;
+
+    for (unsigned s = 0; s < sizes.size(); s++) {
+        for (unsigned a = 0; a < associativities.size(); a++) {
+            for (unsigned l = 0; l < lines.size(); l++) {
+                for (unsigned r = 0; r < replacements.size(); r++) {
+                    for (unsigned x = 0; x < indexing.size(); x++) {
+                        cache_config_t config = {sizes[s]*KB, associativities[a], lines[l], WRITE_BACK, WRITE_ALLOCATE, 5, 100, width, replacements[r], indexing[x]};
+                        if (config.size / config.line_size < config.associativity) continue;
+
+                        //WRITE-BACK, WRITE-ALLOCATE
+                        if (write_back) design.add(config);
+
+                        //WRITE-THROUGH, NO-WRITE-ALLOCATE
+                        config.write_hit_policy = WRITE_THROUGH;
+                        config.write_miss_policy = NO_WRITE_ALLOCATE;
+                        if (write_through) design.add(config);
+                    }
+                }
+            }
+        }
+    }
+
+    design.run(threads);
+    design.print_results(cout);
+
+    if (csv != NULL) {
+        ofstream out(csv);
+        design.print_csv(out);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "trace.h"
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace std;
+
+/* Converts a trace (text or binary, optionally gzip/zstd compressed) into the compact binary format read by cache::load_trace */
+/* "-t" converts back to the "r|w 0x<address> [core]" text format, "-c" keeps the core IDs of multi-core traces */
+
+int main(int argc, char **argv){
+
+    bool to_text = false;
+    bool cores = false;
+    int option;
+
+    while ((option = getopt(argc, argv, "tc")) != -1){
+        switch (option){
+            case 't': to_text = true; break;
+            case 'c': cores = true; break;
+            default: argc = 0;
+        }
+    }
+    if (argc - optind != 2){
+        cerr << "usage: " << argv[0] << " [-t] [-c] <input trace> <output trace>" << endl;
+        return 1;
+    }
+
+    const char *input = argv[optind];
+    const char *output = argv[optind+1];
+
+    trace_reader reader;
+    if (!reader.open(input)){
+        cerr << "cannot open trace file " << input << endl;
+        return 1;
+    }
+
+    trace_entry_t entry;
+    unsigned long long count = 0;
+
+    if (to_text){
+        FILE *out = fopen(output, "w");
+        if (out == NULL){
+            cerr << "cannot create trace file " << output << endl;
+            return 1;
+        }
+        while (reader.next(entry)){
+            if (cores){
+                fprintf(out, "%c 0x%llx %u\n", entry.op == TRACE_WRITE ? 'w' : 'r', (unsigned long long)entry.address, entry.core);
+            }else{
+                fprintf(out, "%c 0x%llx\n", entry.op == TRACE_WRITE ? 'w' : 'r', (unsigned long long)entry.address);
+            }
+            count++;
+        }
+        if (fclose(out) != 0){
+            cerr << "error writing " << output << endl;
+            return 1;
+        }
+    }else{
+        trace_writer writer;
+        if (!writer.open(output, cores)){
+            cerr << "cannot create trace file " << output << endl;
+            return 1;
+        }
+        while (reader.next(entry)){
+            writer.write(entry);
+            count++;
+        }
+        if (!writer.close()){
+            cerr << "error writing " << output << endl;
+            return 1;
+        }
+    }
+
+    cout << count << " memory accesses converted" << endl;
+    return 0;
+}
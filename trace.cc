@@ -0,0 +1,531 @@
+#include "trace.h"
+#include "pipeline.h"
+#include "compress.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STREAM_BUFFER (1 << 20) //read buffer size in TRACE_STREAM mode and write buffer size of trace_writer
+#define MAX_LINE 256            //longest trace line guaranteed to be parsed in one piece
+
+static const trace_entry_t no_entries[1] = {}; //position of an exhausted pipeline
+
+#define ONES  0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+/* loads up to 8 bytes starting at p (zero padded past limit), first character in the low byte */
+static inline unsigned long long load8(const char *p, const char *limit){
+    unsigned long long word = 0;
+    size_t avail = limit - p;
+    memcpy(&word, p, avail < 8 ? avail : 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+/* number of leading hex digits [0-9a-fA-F] in the word: per-byte range checks on the low 7 bits (which
+   cannot carry into the next byte), bytes above 0x7F excluded */
+static inline unsigned digits8(unsigned long long word){
+    unsigned long long low = word & (0x7F * ONES);
+    unsigned long long folded = low | (0x20 * ONES); // lower case
+    unsigned long long decimal = ((127 + '9' + 1) * ONES - low) & (low + (127 - ('0' - 1)) * ONES);
+    unsigned long long letter = ((127 + 'f' + 1) * ONES - folded) & (folded + (127 - ('a' - 1)) * ONES);
+    unsigned long long stop = ~((decimal | letter) & ~word) & HIGHS;
+    return stop ? __builtin_ctzll(stop) >> 3 : 8;
+}
+
+/* converts 8 hex digits (most significant digit in the low byte) into their 32-bit value */
+static inline unsigned long long hex8(unsigned long long word){
+    word = (word & 0x0F0F0F0F0F0F0F0FULL) + ((word >> 6) & ONES) * 9;
+    word = ((word << 4) | (word >> 8)) & 0x00FF00FF00FF00FFULL;
+    word = ((word << 8) | (word >> 16)) & 0x0000FFFF0000FFFFULL;
+    word = ((word << 16) | (word >> 32)) & 0x00000000FFFFFFFFULL;
+    return word;
+}
+
+/* parses up to 16 hex digits at p without a per-digit loop; stores the number of digits consumed in len */
+static inline unsigned long long parse_hex(const char *p, const char *limit, unsigned *len){
+    unsigned long long word = load8(p, limit);
+    unsigned n = digits8(word);
+
+    if (n == 0){
+        *len = 0;
+        return 0;
+    }
+    if (n < 8){
+        *len = n;
+        return hex8(word << ((8 - n) * 8));
+    }
+
+    n += digits8(load8(p + 8, limit));
+    *len = n;
+    if (n == 8) return hex8(word);
+    return (hex8(word << ((16 - n) * 8)) << 32) | hex8(load8(p + n - 8, limit));
+}
+
+trace_reader::trace_reader(){
+    fd = -1;
+    mode = TRACE_MMAP;
+    buffer = NULL;
+    capacity = 0;
+    cursor = NULL;
+    limit = NULL;
+    eof = true;
+    decoded = NULL;
+    decoded_end = NULL;
+    source = NULL;
+    batch = NULL;
+    pipeline = NULL;
+    inflater = NULL;
+    borrowed = false;
+    consumed = 0;
+    resting = false;
+    format = TRACE_TEXT;
+    cores = false;
+    previous = 0;
+}
+
+trace_reader::~trace_reader(){
+    close();
+}
+
+bool trace_reader::open(const char *filename, trace_mode_t trace_mode){
+    struct stat info;
+
+    close();
+    if (trace_mode == TRACE_PIPELINE){
+        pipeline = new trace_pipeline();
+        if (!pipeline->open(filename)){
+            close();
+            return false;
+        }
+        format = pipeline->get_format();
+        decoded = decoded_end = no_entries;
+        return true;
+    }
+
+    fd = ::open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    mode = trace_mode;
+    if (mode == TRACE_MMAP){
+        void *map = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+            map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        if (map != MAP_FAILED && detect_compression((const unsigned char *)map, info.st_size) != COMPRESSION_NONE){
+            // compressed: decompressed while streaming instead, in bounded memory
+            munmap(map, info.st_size);
+            map = MAP_FAILED;
+        }
+        if (map != MAP_FAILED){
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            buffer = (char *)map;
+            capacity = info.st_size;
+            cursor = buffer;
+            limit = buffer + capacity;
+            eof = true;
+            detect_format();
+            return true;
+        }
+        mode = TRACE_STREAM;
+    }
+
+    capacity = STREAM_BUFFER;
+    buffer = (char *)malloc(capacity);
+    cursor = buffer;
+    limit = buffer;
+    eof = false;
+
+    /* the first bytes tell compressed files apart; they are replayed to the decompressor */
+    while (limit - buffer < COMPRESSION_MAGIC){
+        ssize_t n = ::read(fd, (char *)limit, COMPRESSION_MAGIC - (limit - buffer));
+        if (n <= 0) break;
+        limit += n;
+    }
+    compression_t compression = detect_compression((const unsigned char *)buffer, limit - buffer);
+    if (compression != COMPRESSION_NONE){
+        inflater = new decompressor();
+        if (!inflater->open(fd, compression, buffer, limit - buffer)){
+            close();
+            return false;
+        }
+        limit = buffer;
+    }
+
+    refill();
+    detect_format();
+    return true;
+}
+
+bool trace_reader::open(const char *text, size_t size){
+    close();
+    buffer = (char *)text;
+    borrowed = true;
+    capacity = size;
+    cursor = buffer;
+    limit = buffer + size;
+    eof = true;
+    detect_format();
+    return true;
+}
+
+bool trace_reader::open(const trace_entry_t *entries, size_t count){
+    close();
+    decoded = entries;
+    decoded_end = entries + count;
+    return true;
+}
+
+bool trace_reader::open(trace_source *generator){
+    close();
+    batch = (trace_entry_t *)malloc(SOURCE_BATCH * sizeof(trace_entry_t));
+    if (batch == NULL) return false;
+    source = generator;
+    decoded = batch;
+    decoded_end = batch;
+    return true;
+}
+
+void trace_reader::detect_format(){
+    format = TRACE_TEXT;
+    cores = false;
+    previous = 0;
+    if ((limit - cursor) >= TRACE_HEADER && !memcmp(cursor, TRACE_MAGIC, 4) && cursor[4] == TRACE_VERSION){
+        format = TRACE_BINARY;
+        cores = (cursor[5] & TRACE_CORES) != 0;
+        cursor += TRACE_HEADER;
+    }
+}
+
+void trace_reader::close(){
+    if (buffer != NULL && !borrowed){
+        if (mode == TRACE_MMAP){
+            munmap(buffer, capacity);
+        }else{
+            free(buffer);
+        }
+    }
+    delete inflater;
+    inflater = NULL;
+    if (fd >= 0) ::close(fd);
+
+    fd = -1;
+    buffer = NULL;
+    capacity = 0;
+    cursor = NULL;
+    limit = NULL;
+    eof = true;
+    decoded = NULL;
+    decoded_end = NULL;
+    free(batch);
+    source = NULL;
+    batch = NULL;
+    delete pipeline;
+    pipeline = NULL;
+    borrowed = false;
+    consumed = 0;
+    resting = false;
+}
+
+void trace_reader::refill(){
+    if (eof) return;
+
+    size_t left = limit - cursor;
+    memmove(buffer, cursor, left);
+    cursor = buffer;
+    limit = buffer + left;
+
+    while (size_t(limit - buffer) < capacity){
+        size_t room = capacity - (limit - buffer);
+        ssize_t n = (inflater != NULL) ? inflater->read((char *)limit, room) : ::read(fd, (char *)limit, room);
+        if (n <= 0){
+            eof = true;
+            break;
+        }
+        limit += n;
+    }
+}
+
+bool trace_reader::next_text(trace_entry_t &entry){
+    for (;;){
+        if ((limit - cursor) < MAX_LINE) refill();
+
+        while (cursor < limit && (unsigned char)*cursor <= ' ') cursor++;
+        if (cursor == limit){
+            if (eof) return false;
+            refill();
+            continue;
+        }
+
+        char op = *cursor++;
+        while (cursor < limit && (*cursor == ' ' || *cursor == '\t')) cursor++;
+        if ((limit - cursor) >= 2 && cursor[0] == '0' && (cursor[1] | 0x20) == 'x') cursor += 2;
+
+        unsigned len;
+        entry.address = (address_t)parse_hex(cursor, limit, &len);
+        cursor += len;
+
+        /* optional core ID */
+        while (cursor < limit && (*cursor == ' ' || *cursor == '\t')) cursor++;
+        unsigned core = 0;
+        while (cursor < limit && (unsigned)(*cursor - '0') < 10) core = core * 10 + (*cursor++ - '0');
+        entry.core = core;
+        entry.reads = 0;
+        entry.writes = 0;
+
+        /* skip whatever is left on the line */
+        const char *end = (const char *)memchr(cursor, '\n', limit - cursor);
+        while (end == NULL && !eof){
+            cursor = limit;
+            refill();
+            end = (const char *)memchr(cursor, '\n', limit - cursor);
+        }
+        cursor = (end != NULL) ? end + 1 : limit;
+
+        if (op == 'w'){
+            entry.op = TRACE_WRITE;
+            return true;
+        }
+        if (op == 'r'){
+            entry.op = TRACE_READ;
+            return true;
+        }
+        // any other op is not an access
+    }
+}
+
+bool trace_reader::next_binary(trace_entry_t &entry){
+    if ((limit - cursor) < TRACE_MAX_RECORD) refill();
+    if (cursor == limit) return false;
+
+    const unsigned char *p = (const unsigned char *)cursor;
+    const unsigned char *end = (const unsigned char *)limit;
+    unsigned byte = *p++;
+    unsigned long long zigzag = (byte >> 1) & 0x3F;
+    unsigned shift = 6;
+
+    entry.op = (byte & 1) ? TRACE_WRITE : TRACE_READ;
+    while ((byte & 0x80) && p < end && shift < 64){
+        byte = *p++;
+        zigzag |= (unsigned long long)(byte & 0x7F) << shift;
+        shift += 7;
+    }
+    entry.core = 0;
+    entry.reads = 0;
+    entry.writes = 0;
+    if (cores){
+        unsigned core = 0;
+        shift = 0;
+        do {
+            byte = (p < end) ? *p++ : 0;
+            core |= (byte & 0x7F) << shift;
+            shift += 7;
+        } while ((byte & 0x80) && shift < 32);
+        entry.core = core;
+    }
+    cursor = (const char *)p;
+
+    unsigned long long delta = (zigzag >> 1) ^ (0 - (zigzag & 1));
+    previous = (address_t)((unsigned long long)previous + delta);
+    entry.address = previous;
+    return true;
+}
+
+bool trace_reader::pull(){
+    if (source != NULL){
+        decoded = batch;
+        decoded_end = batch + source->fill(batch, SOURCE_BATCH);
+        return decoded != decoded_end;
+    }
+    if (pipeline != NULL){
+        size_t count = 0;
+        while (count == 0){
+            if (!pipeline->next(decoded, count)){
+                decoded = decoded_end = no_entries;
+                return false;
+            }
+        }
+        decoded_end = decoded + count;
+        return true;
+    }
+    return false;
+}
+
+bool trace_reader::next(trace_entry_t &entry){
+    if (__builtin_expect(resting, 0)){
+        entry = rest;
+        resting = false;
+        return true;
+    }
+    if (decoded != NULL){
+        if (decoded == decoded_end && !pull()) return false;
+        entry = *decoded++;
+        consumed++;
+        return true;
+    }
+    if (buffer == NULL) return false;
+    bool found = (format == TRACE_BINARY) ? next_binary(entry) : next_text(entry);
+    consumed += found;
+    return found;
+}
+
+bool trace_reader::next(trace_entry_t &entry, unsigned long long budget){
+    if (!next(entry)) return false;
+    if (trace_accesses(entry) <= budget) return true;
+
+    trace_cut(entry, budget, rest);
+    resting = true;
+    return true;
+}
+
+trace_format_t trace_reader::get_format(){
+    return format;
+}
+
+bool trace_reader::is_open(){
+    return buffer != NULL || decoded != NULL;
+}
+
+unsigned long long trace_reader::position(){
+    return consumed;
+}
+
+unsigned long long trace_reader::skip(unsigned long long count){
+    unsigned long long skipped = 0;
+    trace_entry_t entry;
+
+    while (skipped < count){
+        if (!resting && decoded != NULL && decoded != decoded_end){
+            // decoded accesses are passed over without copying them
+            size_t step = decoded_end - decoded;
+            if (step > count - skipped) step = count - skipped;
+            decoded += step;
+            consumed += step;
+            skipped += step;
+            continue;
+        }
+        if (!next(entry)) break;
+        skipped++;
+    }
+    return skipped;
+}
+
+unsigned long long trace_reader::pass(unsigned long long count){
+    unsigned long long passed = 0;
+    trace_entry_t entry;
+
+    while (passed < count){
+        if (!resting && decoded != NULL && decoded != decoded_end){
+            // plain decoded accesses are passed over without copying them
+            const trace_entry_t *start = decoded;
+            const trace_entry_t *end = (count - passed < (size_t)(decoded_end - decoded)) ? decoded + (count - passed) : decoded_end;
+            while (decoded != end && (decoded->reads | decoded->writes) == 0) {
+                decoded++;
+            }
+            consumed += decoded - start;
+            passed += decoded - start;
+            if (decoded != start) continue;
+        }
+        if (!next(entry, count - passed)) break;
+        passed += trace_accesses(entry);
+    }
+    return passed;
+}
+
+bool trace_reader::pending(trace_entry_t &entry){
+    if (resting) entry = rest;
+    return resting;
+}
+
+void trace_reader::hold(const trace_entry_t &entry){
+    rest = entry;
+    resting = true;
+}
+
+trace_writer::trace_writer(){
+    fd = -1;
+    buffer = NULL;
+    used = 0;
+    previous = 0;
+    cores = false;
+}
+
+trace_writer::~trace_writer(){
+    close();
+}
+
+bool trace_writer::open(const char *filename, bool with_cores){
+    close();
+    fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    buffer = (unsigned char *)malloc(STREAM_BUFFER);
+    used = 0;
+    previous = 0;
+
+    cores = with_cores;
+    memcpy(buffer, TRACE_MAGIC, 4);
+    buffer[4] = TRACE_VERSION;
+    memset(buffer + 5, 0, TRACE_HEADER - 5);
+    buffer[5] = cores ? TRACE_CORES : 0;
+    used = TRACE_HEADER;
+    return true;
+}
+
+bool trace_writer::flush(){
+    size_t done = 0;
+    while (done < used){
+        ssize_t n = ::write(fd, buffer + done, used - done);
+        if (n <= 0) return false;
+        done += n;
+    }
+    used = 0;
+    return true;
+}
+
+bool trace_writer::write(const trace_entry_t &entry){
+    if (fd < 0) return false;
+    if (STREAM_BUFFER - used < TRACE_MAX_RECORD && !flush()) return false;
+
+    long long delta = (long long)((unsigned long long)entry.address - (unsigned long long)previous);
+    unsigned long long zigzag = ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63);
+    previous = entry.address;
+
+    unsigned char *p = buffer + used;
+    unsigned byte = ((zigzag & 0x3F) << 1) | (entry.op == TRACE_WRITE ? 1 : 0);
+    zigzag >>= 6;
+    while (zigzag != 0){
+        *p++ = byte | 0x80;
+        byte = zigzag & 0x7F;
+        zigzag >>= 7;
+    }
+    *p++ = byte;
+    if (cores){
+        unsigned core = entry.core;
+        while (core >= 0x80){
+            *p++ = (core & 0x7F) | 0x80;
+            core >>= 7;
+        }
+        *p++ = core;
+    }
+    used = p - buffer;
+    return true;
+}
+
+bool trace_writer::close(){
+    bool ok = true;
+    if (fd >= 0){
+        ok = flush();
+        ok = (::close(fd) == 0) && ok;
+    }
+    free(buffer);
+    fd = -1;
+    buffer = NULL;
+    used = 0;
+    return ok;
+}
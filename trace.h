@@ -0,0 +1,225 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+typedef long long address_t; //memory address type
+
+/*
+* TRACE_MMAP maps the file and parses it in place, TRACE_STREAM reads it through a buffer and
+* TRACE_PIPELINE decodes it ahead on helper threads (see pipeline.h)
+*/
+typedef enum {TRACE_MMAP, TRACE_STREAM, TRACE_PIPELINE} trace_mode_t;
+
+typedef enum {TRACE_READ, TRACE_WRITE} trace_op_t;
+
+typedef enum {TRACE_TEXT, TRACE_BINARY} trace_format_t;
+
+/*
+* Text traces hold one "r|w <hex address> [core]" line per access; the decimal core ID of multi-core
+* traces (see multicore.h) is optional and defaults to 0. Blank lines and lines whose op is neither r
+* nor w are skipped: they are not accesses.
+* Binary trace layout: an 8-byte header (TRACE_MAGIC, version, flags, 2 reserved bytes) followed by one
+* varint record per access. The record encodes the zigzagged delta from the previous address
+* (starting at 0) with the op folded into bit 0 of the first byte:
+*   first byte:  [continue:1][delta bits 0-5][write:1]
+*   next bytes:  [continue:1][next 7 delta bits]
+* With the TRACE_CORES flag every record is followed by the core ID as a plain varint.
+*/
+#define TRACE_MAGIC "CTRB"
+#define TRACE_VERSION 1
+#define TRACE_HEADER 8
+#define TRACE_MAX_RECORD 15
+#define TRACE_CORES 0x1 //header flag: records carry a core ID
+
+/* one decoded memory access */
+typedef struct{
+    address_t address;
+    trace_op_t op;
+    unsigned core;   // issuing core of multi-core traces, 0 otherwise
+    unsigned reads;  // run records (see runs.h): reads, then writes, of the same line folded after
+    unsigned writes; // this access; 0 for plain accesses
+} trace_entry_t;
+
+// number of accesses "entry" stands for
+static inline unsigned long long trace_accesses(const trace_entry_t &entry){
+    return 1ULL + entry.reads + entry.writes;
+}
+
+// cuts the run record "entry" after "budget" of its accesses (0 < budget < trace_accesses(entry)): "entry"
+// keeps its access and the first budget - 1 folded ones (reads come first), "rest" gets the others, led by
+// the first of them; those were all hits or all non-allocating write misses, so both parts stay exact
+static inline void trace_cut(trace_entry_t &entry, unsigned long long budget, trace_entry_t &rest){
+    unsigned long long folded = budget - 1;
+    rest = entry;
+    entry.reads = (entry.reads < folded) ? entry.reads : folded;
+    entry.writes = folded - entry.reads;
+    rest.reads -= entry.reads;
+    rest.writes -= entry.writes;
+    if (rest.reads){
+        rest.op = TRACE_READ;
+        rest.reads--;
+    }else{
+        rest.op = TRACE_WRITE;
+        rest.writes--;
+    }
+}
+
+/* producer of accesses generated on the fly (see workload.h), read by trace_reader in batches */
+class trace_source{
+
+public:
+
+    virtual ~trace_source(){}
+
+    // stores up to "max" accesses in "entries"; returns how many (0 at the end of the stream)
+    virtual size_t fill(trace_entry_t *entries, size_t max) = 0;
+};
+
+#define SOURCE_BATCH 4096 //accesses pulled from a trace_source at a time
+
+class trace_pipeline;
+class decompressor;
+
+class trace_reader{
+
+    /* trace file descriptor and reading mode */
+    int fd;
+    trace_mode_t mode;
+
+    /* input window: the whole mapping (TRACE_MMAP), a refillable read buffer (TRACE_STREAM) or text
+       owned by the caller ("borrowed") */
+    char *buffer;
+    bool borrowed;
+    size_t capacity;
+    const char *cursor;
+    const char *limit;
+    bool eof;
+
+    /* already decoded accesses shared with other readers (see open(entries, count)) */
+    const trace_entry_t *decoded;
+    const trace_entry_t *decoded_end;
+
+    /* generated accesses: the source refills "batch" and "decoded" walks it */
+    trace_source *source;
+    trace_entry_t *batch;
+
+    /* TRACE_PIPELINE: "decoded" walks the chunks handed out by the decoder threads */
+    trace_pipeline *pipeline;
+
+    /* gzip/zstd compressed files: refill() reads the decompressed stream (see compress.h) */
+    decompressor *inflater;
+
+    // moves "decoded" to the next batch of generated or pipelined accesses; false at the end
+    bool pull();
+
+    /* accesses handed out since the trace was opened */
+    unsigned long long consumed;
+
+    /* what next(entry, budget) left of a run record, returned first by the next call */
+    trace_entry_t rest;
+    bool resting;
+
+    /* detected file format, whether binary records carry a core and the last decoded address (binary deltas) */
+    trace_format_t format;
+    bool cores;
+    address_t previous;
+
+    // moves the unread bytes to the front of the buffer and reads more from the file
+    void refill();
+
+    // parses the next "r|w <hex address>" line from the window
+    bool next_text(trace_entry_t &entry);
+
+    // decodes the next varint record from the window
+    bool next_binary(trace_entry_t &entry);
+
+    // recognizes the binary header at the start of the window and skips it
+    void detect_format();
+
+public:
+
+    trace_reader();
+
+    ~trace_reader();
+
+    // opens the trace file (with name "filename"), falling back to TRACE_STREAM when it cannot be mapped
+    // text and binary traces are told apart by the header; gzip and zstd compressed traces are
+    // recognized by their magic bytes and decompressed while streaming (never mapped)
+    bool open(const char *filename, trace_mode_t mode=TRACE_MMAP);
+
+    // parses text trace lines held in memory; the text is not copied and must outlive the reader
+    bool open(const char *text, size_t size);
+
+    // reads "count" accesses already decoded in memory; the array is not copied and must outlive the reader
+    bool open(const trace_entry_t *entries, size_t count);
+
+    // reads the accesses produced by "source", which must outlive the reader; no file is involved
+    bool open(trace_source *source);
+
+    // releases the mapping/buffer and closes the file
+    void close();
+
+    // decodes the next access; returns false at the end of the trace
+    bool next(trace_entry_t &entry);
+
+    // same as next, with a run record cut after "budget" (> 0) accesses; the rest of it comes next,
+    // as a record led by the first of its remaining accesses
+    bool next(trace_entry_t &entry, unsigned long long budget);
+
+    // format of the currently open trace
+    trace_format_t get_format();
+
+    // true while a trace (of any kind) is open
+    bool is_open();
+
+    // number of entries (accesses or run records) returned by next() (or skipped) since the trace was opened
+    unsigned long long position();
+
+    // moves past the next "count" entries without returning them; returns how many were skipped
+    unsigned long long skip(unsigned long long count);
+
+    // moves past the next "count" accesses, cutting the last run record like next(entry, budget);
+    // returns how many were passed
+    unsigned long long pass(unsigned long long count);
+
+    // copies what next(entry, budget) left of a cut run record to "entry"; false when nothing is left
+    bool pending(trace_entry_t &entry);
+
+    // makes "entry" (the rest of a cut run record) the next one returned, ahead of position()
+    void hold(const trace_entry_t &entry);
+};
+
+class trace_writer{
+
+    /* output file descriptor and write buffer */
+    int fd;
+    unsigned char *buffer;
+    size_t used;
+
+    /* last encoded address and whether records carry a core */
+    address_t previous;
+    bool cores;
+
+    // writes the buffered records to the file
+    bool flush();
+
+public:
+
+    trace_writer();
+
+    ~trace_writer();
+
+    // creates the binary trace file (with name "filename") and writes its header; "with_cores" keeps the
+    // core ID of every access
+    bool open(const char *filename, bool with_cores=false);
+
+    // appends one access
+    bool write(const trace_entry_t &entry);
+
+    // flushes the remaining records and closes the file
+    bool close();
+};
+
+#endif /*TRACE_H_*/
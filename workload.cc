@@ -0,0 +1,121 @@
+#include "workload.h"
+#include <math.h>
+#include <algorithm>
+
+#define START 0x0
+
+workload::workload(const workload_config_t &workload_config){
+    config = workload_config;
+    if (config.stride == 0) config.stride = 1;
+    if (config.element == 0 || config.element > config.stride) config.element = config.stride;
+    items = config.footprint / config.stride;
+    if (items == 0) items = 1;
+
+    write_threshold = (unsigned long long)(config.write_ratio * 4294967296.0);
+
+    if (config.pattern == WORKLOAD_ZIPF) {
+        theta = config.zipf_exponent;
+        zeta_items = 0;
+        for (unsigned long long i = 1; i <= items; i++) {
+            zeta_items += 1.0 / pow((double)i, theta);
+        }
+        if (theta < 1) {
+            double zeta_two = 1 + 1.0 / pow(2.0, theta);
+            alpha = 1.0 / (1.0 - theta);
+            eta = (1 - pow(2.0 / items, 1 - theta)) / (1 - zeta_two / zeta_items);
+            half_pow = 1 + pow(0.5, theta);
+        }else{
+            // the quick generator needs theta < 1: invert the cumulative distribution instead
+            double sum = 0;
+            cdf.resize(items);
+            for (unsigned long long i = 0; i < items; i++) {
+                sum += 1.0 / pow((double)(i + 1), theta);
+                cdf[i] = sum / zeta_items;
+            }
+        }
+    }
+
+    reset();
+
+    if (config.pattern == WORKLOAD_POINTER_CHASE) {
+        // Sattolo's shuffle: a single cycle through every item
+        chain.resize(items);
+        for (unsigned long long i = 0; i < items; i++) {
+            chain[i] = i;
+        }
+        for (unsigned long long i = items - 1; i > 0; i--) {
+            unsigned long long j = (unsigned long long)(((unsigned __int128)random64() * i) >> 64);
+            swap(chain[i], chain[j]);
+        }
+        reset();
+    }
+}
+
+void workload::reset(){
+    produced = START;
+    item = START;
+    pass = START;
+    state = config.seed;
+}
+
+/* splitmix64: every seed (including 0) gives a full-period, well mixed sequence */
+unsigned long long workload::random64(){
+    unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+unsigned long long workload::next_offset(){
+    unsigned long long offset;
+
+    switch (config.pattern) {
+        case WORKLOAD_SEQUENTIAL:
+            offset = item * config.stride;
+            item = (item + 1 == items) ? 0 : item + 1;
+            return offset;
+
+        case WORKLOAD_STRIDED:
+            offset = pass * config.element + item * config.stride;
+            item++;
+            if (item == items || pass * config.element + item * config.stride >= config.footprint) {
+                item = START;
+                pass = (pass + 1) % (config.stride / config.element);
+            }
+            return offset;
+
+        case WORKLOAD_UNIFORM:
+            return (unsigned long long)(((unsigned __int128)random64() * items) >> 64) * config.stride;
+
+        case WORKLOAD_ZIPF: {
+            double u = (random64() >> 11) * (1.0 / 9007199254740992.0);
+            unsigned long long rank;
+            if (theta >= 1) {
+                rank = lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+            }else{
+                double uz = u * zeta_items;
+                if (uz < 1) rank = 0;
+                else if (uz < half_pow) rank = 1;
+                else rank = (unsigned long long)(items * pow(eta * u - eta + 1, alpha));
+            }
+            return ((rank < items) ? rank : items - 1) * config.stride;
+        }
+
+        default:
+            item = chain[item];
+            return item * config.stride;
+    }
+}
+
+size_t workload::fill(trace_entry_t *entries, size_t max){
+    size_t n = START;
+
+    for (; n < max && produced < config.count; n++, produced++) {
+        entries[n].address = (address_t)((unsigned long long)config.base + next_offset());
+        entries[n].op = (write_threshold != 0 && (random64() >> 32) < write_threshold) ? TRACE_WRITE : TRACE_READ;
+        entries[n].core = START;
+        entries[n].reads = START;
+        entries[n].writes = START;
+    }
+    return n;
+}
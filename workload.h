@@ -0,0 +1,77 @@
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+#include <vector>
+#include "trace.h"
+
+using namespace std;
+
+typedef enum {WORKLOAD_SEQUENTIAL, WORKLOAD_STRIDED, WORKLOAD_UNIFORM, WORKLOAD_ZIPF, WORKLOAD_POINTER_CHASE} workload_pattern_t;
+
+/*
+* Synthetic access stream. The footprint is split into "footprint / stride" items of "stride" bytes
+* starting at "base"; the pattern picks the item of every access:
+*   WORKLOAD_SEQUENTIAL:    items 0, 1, 2, ... wrapping around (stride = element size)
+*   WORKLOAD_STRIDED:       same walk, restarting one element further after every pass
+*                           (element size "element", so every element is visited once per stride/element passes)
+*   WORKLOAD_UNIFORM:       independent uniformly random items
+*   WORKLOAD_ZIPF:          item of rank k drawn with probability ~ 1/k^zipf_exponent (rank 0 is the
+*                           hottest, ranks are laid out in address order)
+*   WORKLOAD_POINTER_CHASE: a random cyclic permutation of the items, each access the successor of the
+*                           previous one (every item once per cycle, no spatial locality)
+* Each access is a write with probability "write_ratio". The stream has "count" accesses and is a pure
+* function of the configuration and "seed".
+*/
+typedef struct{
+    workload_pattern_t pattern;
+    address_t base;
+    unsigned long long footprint;      // bytes
+    unsigned long long stride;         // bytes between consecutive items
+    unsigned long long element;        // WORKLOAD_STRIDED: bytes between passes
+    unsigned long long count;          // accesses
+    double write_ratio;
+    double zipf_exponent;
+    unsigned long long seed;
+} workload_config_t;
+
+class workload : public trace_source{
+
+    workload_config_t config;
+
+    /* number of items and position in the stream (item and pass of the sequential/strided walks) */
+    unsigned long long items;
+    unsigned long long produced;
+    unsigned long long item;
+    unsigned long long pass;
+
+    /* random state and write threshold (of 2^32) */
+    unsigned long long state;
+    unsigned long long write_threshold;
+
+    /* WORKLOAD_ZIPF: Gray et al. quick generator (exponent below 1), else the inverted distribution */
+    double theta;
+    double zeta_items;
+    double alpha;
+    double eta;
+    double half_pow;
+    vector<double> cdf;
+
+    /* WORKLOAD_POINTER_CHASE: successor of every item */
+    vector<unsigned> chain;
+
+    unsigned long long random64();
+
+    // byte offset from "base" of the next access of the pattern
+    unsigned long long next_offset();
+
+public:
+
+    workload(const workload_config_t &config);
+
+    // restarts the stream from its first access
+    void reset();
+
+    size_t fill(trace_entry_t *entries, size_t max);
+};
+
+#endif /*WORKLOAD_H_*/